@@ -0,0 +1,35 @@
+#include <assert.h>
+#include <pthread.h>
+
+pthread_mutex_t m;
+int x = 0;
+
+void *t1(void *arg)
+{
+  pthread_mutex_lock(&m);
+  x = x + 1;
+  pthread_mutex_unlock(&m);
+  return NULL;
+}
+
+void *t2(void *arg)
+{
+  pthread_mutex_lock(&m);
+  x = x + 1;
+  pthread_mutex_unlock(&m);
+  return NULL;
+}
+
+int main()
+{
+  pthread_t id1, id2;
+
+  pthread_mutex_init(&m, NULL);
+  pthread_create(&id1, NULL, t1, NULL);
+  pthread_create(&id2, NULL, t2, NULL);
+  pthread_join(id1, NULL);
+  pthread_join(id2, NULL);
+
+  assert(x == 2);
+  return 0;
+}
@@ -0,0 +1,12 @@
+int nondet_int();
+
+int main()
+{
+  int x = nondet_int();
+
+  // The same subterm appears twice here and once more in the assertion
+  int y = (x * x + 3) * (x * x + 3);
+  assert(y != 7 && x * x + 3 != 5);
+
+  return 0;
+}
@@ -0,0 +1,14 @@
+int nondet_int();
+
+int main()
+{
+  int x = nondet_int();
+  __ESBMC_assume(x > 100 && x < 102);
+
+  // Only reachable at k = 2, so earlier steps hand their solver back first
+  for(int i = 0; i < 2; i++)
+    if(i == 1)
+      assert(x != 101);
+
+  return 0;
+}
@@ -0,0 +1,2 @@
+#!/bin/sh
+exec z3 -in -smt2
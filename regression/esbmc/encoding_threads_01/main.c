@@ -0,0 +1,13 @@
+#include <assert.h>
+
+int nondet_int();
+
+int main()
+{
+  int x = nondet_int();
+
+  __ESBMC_assume(x > 0 && x < 100);
+
+  assert(x * x != 49);
+  return 0;
+}
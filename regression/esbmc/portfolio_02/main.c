@@ -0,0 +1,14 @@
+#include <assert.h>
+
+int nondet_int();
+
+int main()
+{
+  int x = nondet_int();
+
+  __ESBMC_assume(x > 0 && x < 100);
+
+  assert(x != 0);
+  assert(x < 100);
+  return 0;
+}
@@ -0,0 +1,13 @@
+#include <assert.h>
+#include <stdio.h>
+
+int nondet_int();
+
+int main()
+{
+  int x = nondet_int();
+  int y = x + 1;
+  printf("y is %d\n", y);
+  assert(y != 5);
+  return 0;
+}
@@ -0,0 +1,19 @@
+#include <assert.h>
+
+int nondet_int();
+
+int main()
+{
+  int a[8];
+  int sum = 0;
+
+  for(int i = 0; i < 8; i++)
+  {
+    a[i] = nondet_int();
+    __ESBMC_assume(a[i] >= 0 && a[i] < 4);
+    sum += a[i] * 2 + 0;
+  }
+
+  assert(sum >= 0 && sum % 2 == 0);
+  return 0;
+}
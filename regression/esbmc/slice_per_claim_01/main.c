@@ -0,0 +1,16 @@
+#include <assert.h>
+
+int nondet_int();
+
+int main()
+{
+  int x = nondet_int();
+  int y = nondet_int();
+
+  __ESBMC_assume(x > 0 && x < 100);
+
+  assert(x != 10);
+  assert(x < 100);
+  assert(y != x + 1);
+  return 0;
+}
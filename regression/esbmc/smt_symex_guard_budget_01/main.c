@@ -0,0 +1,16 @@
+#include <assert.h>
+
+int nondet_int();
+
+int main()
+{
+  int x = nondet_int();
+  if(x > 10)
+  {
+    if(x < 5)
+      assert(0);
+    if(x == 3)
+      assert(0);
+  }
+  return 0;
+}
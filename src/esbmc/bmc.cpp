@@ -7,10 +7,15 @@ Authors: Daniel Kroening, kroening@kroening.com
 
 \*******************************************************************/
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <csignal>
 #include <sys/types.h>
 
 #ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #else
 #include <windows.h>
@@ -29,6 +34,7 @@ Authors: Daniel Kroening, kroening@kroening.com
 #include <goto-symex/reachability_tree.h>
 #include <goto-symex/slice.h>
 #include <goto-symex/xml_goto_trace.h>
+#include <iomanip>
 #include <langapi/language_util.h>
 #include <langapi/languages.h>
 #include <langapi/mode.h>
@@ -50,7 +56,9 @@ bmct::bmct(
     options(opts),
     context(_context),
     ns(context),
-    ui(ui_message_handlert::PLAIN)
+    ui(ui_message_handlert::PLAIN),
+    subtree_claims(nullptr),
+    incremental(nullptr)
 {
   interleaving_number = 0;
   interleaving_failed = 0;
@@ -194,16 +202,72 @@ smt_convt::resultt bmct::run_decision_procedure(
   smt_conv->set_message_handler(message_handler);
   smt_conv->set_verbosity(get_verbosity());
 
+  smt_convt::ast_vec violations;
   fine_timet encode_start = current_time();
-  do_cbmc(smt_conv, eq);
+
+  // Hash the VCCs on several threads first, see
+  // symex_target_equationt::hash_steps
+  unsigned int threads = atoi(options.get_option("encoding-threads").c_str());
+  fine_timet hash_busy = 0, hash_wall = 0;
+  if(threads > 1)
+  {
+    hash_busy = eq->hash_steps(threads);
+    hash_wall = current_time() - encode_start;
+  }
+
+  if(options.get_bool_option("multi-property"))
+    eq->convert_claims(*smt_conv.get(), violations);
+  else if(incremental != nullptr)
+  {
+    unsigned int reused = incremental->prefix.encoded;
+    if(!eq->convert_prefixed(*smt_conv.get(), incremental->prefix))
+    {
+      // The equation doesn't start with what is encoded: start over
+      incremental->prefix = symex_target_equationt::encoded_prefixt();
+      incremental->solver = std::shared_ptr<smt_convt>(create_solver_factory(
+        "", options.get_bool_option("int-encoding"), incremental->ns, options));
+      smt_conv = incremental->solver;
+      smt_conv->set_message_handler(message_handler);
+      smt_conv->set_verbosity(get_verbosity());
+
+      reused = 0;
+      eq->convert_prefixed(*smt_conv.get(), incremental->prefix);
+    }
+
+    std::ostringstream str;
+    str << "Reused " << reused << " encoded SSA steps, "
+        << incremental->prefix.encoded << " now kept in the solver";
+    status(str.str());
+  }
+  else
+    do_cbmc(smt_conv, eq);
   fine_timet encode_stop = current_time();
 
   std::ostringstream str;
   str << "Encoding to solver time: ";
   output_time(encode_stop - encode_start, str);
   str << "s";
+  if(threads > 1)
+  {
+    str << " (hashing on " << threads << " threads: ";
+    output_time(hash_wall, str);
+    str << "s, " << std::fixed << std::setprecision(1)
+        << (hash_wall ? double(hash_busy) / hash_wall : 1.0) << "x speedup)";
+  }
   status(str.str());
 
+  if(options.get_bool_option("memstats"))
+  {
+    std::vector<size_t> levels = smt_conv->ast_arena.level_bytes();
+    std::ostringstream str;
+    str << "SMT AST memory: " << smt_conv->ast_arena.bytes_allocated()
+        << " bytes in " << smt_conv->live_asts.size() << " ASTs (";
+    for(unsigned int i = 0; i < levels.size(); i++)
+      str << (i ? ", " : "") << "level " << i << ": " << levels[i];
+    str << "), " << smt_conv->ast_arena.bytes_reserved() << " bytes reserved";
+    status(str.str());
+  }
+
   if(
     options.get_bool_option("smt-formula-too") ||
     options.get_bool_option("smt-formula-only"))
@@ -217,6 +281,9 @@ smt_convt::resultt bmct::run_decision_procedure(
   ss << "Solving with solver " << smt_conv->solver_text();
   status(ss.str());
 
+  if(options.get_bool_option("multi-property"))
+    return multi_property_check(smt_conv, eq, violations);
+
   fine_timet sat_start = current_time();
   smt_convt::resultt dec_result = smt_conv->dec_solve();
   fine_timet sat_stop = current_time();
@@ -231,6 +298,137 @@ smt_convt::resultt bmct::run_decision_procedure(
   return dec_result;
 }
 
+smt_convt::resultt bmct::multi_property_check(
+  std::shared_ptr<smt_convt> &smt_conv,
+  std::shared_ptr<symex_target_equationt> &eq,
+  const smt_convt::ast_vec &violations)
+{
+  // Pair each claim with the AST that is true when it is violated
+  std::list<std::pair<symex_target_equationt::SSA_stepst::iterator, smt_astt>>
+    remaining;
+  smt_convt::ast_vec::const_iterator v = violations.begin();
+  for(auto it = eq->SSA_steps.begin(); it != eq->SSA_steps.end(); ++it)
+  {
+    if(it->is_assert() && !it->ignore)
+      remaining.emplace_back(it, *v++);
+  }
+  assert(v == violations.end());
+
+  std::size_t num_claims = remaining.size(), num_violated = 0;
+  while(!remaining.empty())
+  {
+    // Ask for a violation of any claim not yet known to fail. The claims found
+    // violated are dropped from the next disjunction, which only strengthens
+    // what has already been asserted, so the solver keeps everything it has
+    // learnt between rounds.
+    smt_convt::ast_vec round;
+    for(auto const &claim : remaining)
+      round.push_back(claim.second);
+    smt_conv->assert_ast(
+      smt_conv->make_n_ary(smt_conv.get(), &smt_convt::mk_or, round));
+
+    fine_timet sat_start = current_time();
+    smt_convt::resultt res = smt_conv->dec_solve();
+    fine_timet sat_stop = current_time();
+
+    std::ostringstream str;
+    str << "Runtime decision procedure (" << remaining.size() << " claims): ";
+    output_time(sat_stop - sat_start, str);
+    str << "s";
+    status(str.str());
+
+    if(res == smt_convt::P_UNSATISFIABLE)
+      break;
+
+    if(res != smt_convt::P_SATISFIABLE)
+      return res;
+
+    error_trace(smt_conv, eq);
+
+    std::size_t found = 0;
+    for(auto it = remaining.begin(); it != remaining.end();)
+    {
+      if(!smt_conv->l_get(it->second).is_true())
+      {
+        ++it;
+        continue;
+      }
+
+      const symex_target_equationt::SSA_stept &step = *it->first;
+      status(
+        "Violated claim: " + step.source.pc->location.as_string() + " " +
+        id2string(step.comment));
+
+      ++found;
+      it = remaining.erase(it);
+    }
+
+    // The model must violate at least one of the claims we asked about
+    if(found == 0)
+    {
+      error("solver model violates none of the remaining claims");
+      return smt_convt::P_ERROR;
+    }
+
+    num_violated += found;
+  }
+
+  std::ostringstream str;
+  str << num_violated << " of " << num_claims << " claim(s) violated";
+  status(str.str());
+
+  return num_violated ? smt_convt::P_SATISFIABLE : smt_convt::P_UNSATISFIABLE;
+}
+
+smt_convt::resultt
+bmct::per_claim_check(std::shared_ptr<symex_target_equationt> &eq)
+{
+  // Every claim gets a formula of its own, with just the steps it depends on
+  claim_slicet slicer(*eq, options.get_bool_option("slice-assumes"));
+
+  std::size_t num_claims = slicer.claims.size(), num_violated = 0;
+  smt_convt::resultt res = smt_convt::P_UNSATISFIABLE;
+  for(std::size_t i = 0; i < num_claims; ++i)
+  {
+    unsigned int claim = slicer.claims[i];
+    BigInt ignored = slicer.slice(std::vector<unsigned int>(1, claim));
+    const symex_target_equationt::SSA_stept &step = slicer.get_step(claim);
+
+    std::ostringstream str;
+    str << "Checking claim " << i + 1 << " of " << num_claims << ": "
+        << step.source.pc->location.as_string() << " (removed " << ignored
+        << " more assignments)";
+    status(str.str());
+
+    runtime_solver = std::shared_ptr<smt_convt>(create_solver_factory(
+      "", options.get_bool_option("int-encoding"), ns, options));
+    res = run_decision_procedure(runtime_solver, eq);
+
+    if(res == smt_convt::P_UNSATISFIABLE || res == smt_convt::P_SMTLIB)
+      continue;
+
+    if(res != smt_convt::P_SATISFIABLE)
+      break;
+
+    error_trace(runtime_solver, eq);
+    status(
+      "Violated claim: " + step.source.pc->location.as_string() + " " +
+      id2string(step.comment));
+    ++num_violated;
+  }
+
+  slicer.restore();
+
+  if(res != smt_convt::P_UNSATISFIABLE && res != smt_convt::P_SATISFIABLE)
+    return res;
+
+  std::ostringstream str;
+  str << num_violated << " of " << num_claims << " claim(s) violated";
+  status(str.str());
+
+  return num_violated ? smt_convt::P_SATISFIABLE : smt_convt::P_UNSATISFIABLE;
+}
+
 void bmct::report_success()
 {
   status("\nVERIFICATION SUCCESSFUL");
@@ -459,7 +657,16 @@ smt_convt::resultt bmct::start_bmc()
 {
   std::shared_ptr<symex_target_equationt> eq;
   smt_convt::resultt res = run(eq);
-  report_trace(res, eq);
+
+  // With --parallel-interleavings, the worker that found the violation has
+  // already reported its trace; with --multi-property or --slice-per-claim,
+  // every trace was reported as soon as it was found
+  if(
+    res != smt_convt::P_SATISFIABLE ||
+    (eq && !options.get_bool_option("multi-property") &&
+     !options.get_bool_option("slice-per-claim")))
+    report_trace(res, eq);
+
   report_result(res);
   return res;
 }
@@ -467,14 +674,40 @@ smt_convt::resultt bmct::start_bmc()
 smt_convt::resultt bmct::run(std::shared_ptr<symex_target_equationt> &eq)
 {
   symex->options.set_option("unwind", options.get_option("unwind"));
+
+  // Name dynamic objects as for the previous bound, so that the equations
+  // share their prefix
+  if(incremental != nullptr)
+  {
+    if(!incremental->solver)
+      incremental->dynamic_counter =
+        execution_statet::global_dynamic_counter();
+    else
+      execution_statet::global_dynamic_counter() =
+        incremental->dynamic_counter;
+  }
+
   symex->setup_for_new_explore();
 
   if(options.get_bool_option("schedule"))
     return run_thread(eq);
 
-  smt_convt::resultt res;
+  if(!options.get_option("parallel-interleavings").empty())
+    return run_parallel_interleavings(eq);
+
+  return run_interleavings(eq);
+}
+
+smt_convt::resultt
+bmct::run_interleavings(std::shared_ptr<symex_target_equationt> &eq)
+{
+  smt_convt::resultt res = smt_convt::P_UNSATISFIABLE;
   do
   {
+    // Another --parallel-interleavings worker has already found a violation
+    if(subtree_claims != nullptr && subtree_claims->cancel)
+      break;
+
     if(++interleaving_number > 1)
     {
       std::cout << "*** Thread interleavings " << interleaving_number << " ***"
@@ -484,7 +717,14 @@ smt_convt::resultt bmct::run(std::shared_ptr<symex_target_equationt> &eq)
     fine_timet bmc_start = current_time();
     res = run_thread(eq);
 
-    if(res == smt_convt::P_SATISFIABLE)
+    // This interleaving is checked by another --parallel-interleavings worker
+    if(!symex->owns_current_interleaving())
+    {
+      --interleaving_number;
+      continue;
+    }
+
+    if(res == smt_convt::P_SATISFIABLE && runtime_solver)
     {
       if(config.options.get_bool_option("smt-model"))
         runtime_solver->print_model();
@@ -518,6 +758,139 @@ smt_convt::resultt bmct::run(std::shared_ptr<symex_target_equationt> &eq)
   return interleaving_failed > 0 ? smt_convt::P_SATISFIABLE : res;
 }
 
+smt_convt::resultt
+bmct::run_parallel_interleavings(std::shared_ptr<symex_target_equationt> &eq)
+{
+#ifdef _WIN32
+  std::cerr << "Windows does not support parallel interleavings\n";
+  abort();
+#else
+  unsigned int num_workers =
+    atoi(options.get_option("parallel-interleavings").c_str());
+  unsigned int depth =
+    atoi(options.get_option("parallel-interleavings-depth").c_str());
+
+  // The claims table is written by all workers, so it must be shared memory
+  void *mem = mmap(
+    nullptr,
+    sizeof(reachability_treet::subtree_claimst),
+    PROT_READ | PROT_WRITE,
+    MAP_SHARED | MAP_ANONYMOUS,
+    -1,
+    0);
+  if(mem == MAP_FAILED)
+  {
+    error("Couldn't allocate memory shared with interleaving workers");
+    return smt_convt::P_ERROR;
+  }
+
+  reachability_treet::subtree_claimst *claims =
+    new(mem) reachability_treet::subtree_claimst();
+
+  // Don't let the workers inherit (and print again) buffered output
+  std::cout.flush();
+  fflush(stdout);
+
+  std::vector<pid_t> children_pid;
+  for(unsigned int w = 0; w < num_workers; ++w)
+  {
+    pid_t pid = fork();
+
+    if(pid == -1)
+    {
+      status("\nFork Failed, giving up.");
+      for(pid_t i : children_pid)
+        kill(i, SIGKILL);
+      _exit(1);
+    }
+
+    // Worker process: explore the subtrees it manages to claim, and never
+    // return into the caller, which belongs to the parent.
+    if(!pid)
+    {
+      solvers_forked_child();
+      subtree_claims = claims;
+      symex->set_subtree_claims(claims, w, depth);
+
+      smt_convt::resultt res = run_interleavings(eq);
+      claims->interleavings += interleaving_number.to_uint64();
+      claims->failed += interleaving_failed.to_uint64();
+
+      if(res == smt_convt::P_SATISFIABLE)
+      {
+        int none = -1;
+        if(claims->winner.compare_exchange_strong(none, w))
+          report_trace(res, eq);
+
+        if(!options.get_bool_option("all-runs"))
+          claims->cancel = true;
+      }
+
+      std::cout.flush();
+      fflush(stdout);
+      _exit(res);
+    }
+
+    children_pid.push_back(pid);
+  }
+
+  // Wait for the workers; unless --all-runs is set, the first violation
+  // found makes the remaining ones pointless.
+  smt_convt::resultt res = smt_convt::P_UNSATISFIABLE;
+  while(!children_pid.empty())
+  {
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if(pid == -1)
+    {
+      if(errno == EINTR)
+        continue;
+      break;
+    }
+
+    auto it = std::find(children_pid.begin(), children_pid.end(), pid);
+    if(it == children_pid.end())
+      continue;
+    children_pid.erase(it);
+
+    bool stop = false;
+    if(!WIFEXITED(status) || WEXITSTATUS(status) == smt_convt::P_ERROR)
+    {
+      std::cout << "**** WARNING: Interleaving worker process crashed."
+                << std::endl;
+      res = smt_convt::P_ERROR;
+      stop = true;
+    }
+    else if(WEXITSTATUS(status) == smt_convt::P_SATISFIABLE)
+    {
+      res = smt_convt::P_SATISFIABLE;
+      stop = !options.get_bool_option("all-runs");
+    }
+    else if(
+      WEXITSTATUS(status) == smt_convt::P_SMTLIB &&
+      res == smt_convt::P_UNSATISFIABLE)
+    {
+      res = smt_convt::P_SMTLIB;
+    }
+
+    if(stop)
+    {
+      claims->cancel = true;
+      for(pid_t i : children_pid)
+        kill(i, SIGKILL);
+    }
+  }
+
+  interleaving_number = claims->interleavings.load();
+  interleaving_failed = claims->failed.load();
+
+  claims->~subtree_claimst();
+  munmap(mem, sizeof(reachability_treet::subtree_claimst));
+
+  return res;
+#endif
+}
+
 void bmct::bidirectional_search(
   std::shared_ptr<smt_convt> &smt_conv,
   std::shared_ptr<symex_target_equationt> &eq)
@@ -531,7 +904,7 @@ void bmct::bidirectional_search(
   // We'll walk list of SSA steps and look for inductive assignments
   std::vector<stack_framet> frames;
   unsigned assert_loop_number = 0;
-  for(auto ssait : eq->SSA_steps)
+  for(auto const &ssait : eq->SSA_steps)
   {
     if(ssait.is_assert() && smt_conv->l_get(ssait.cond_ast).is_false())
     {
@@ -539,7 +912,7 @@ void bmct::bidirectional_search(
         return;
 
       // Save the location of the failed assertion
-      frames = ssait.stack_trace;
+      frames = eq->get_stack_trace(ssait);
       assert_loop_number = ssait.loop_number;
 
       // We are not interested in instructions before the failed assertion yet
@@ -648,6 +1021,148 @@ void bmct::bidirectional_search(
   }
 }
 
+smt_convt::resultt
+bmct::run_portfolio(std::shared_ptr<symex_target_equationt> &eq)
+{
+#ifdef _WIN32
+  std::cerr << "Windows does not support --portfolio\n";
+  abort();
+#else
+  std::vector<std::string> solvers;
+  std::istringstream names(options.get_option("portfolio"));
+  std::string name;
+  while(std::getline(names, name, ','))
+  {
+    if(!name.empty())
+      solvers.push_back(name);
+  }
+
+  if(solvers.empty())
+  {
+    error("--portfolio requires at least one solver");
+    return smt_convt::P_ERROR;
+  }
+
+  // Index of the first solver to answer, written by the solver processes
+  void *mem = mmap(
+    nullptr,
+    sizeof(std::atomic<int>),
+    PROT_READ | PROT_WRITE,
+    MAP_SHARED | MAP_ANONYMOUS,
+    -1,
+    0);
+  if(mem == MAP_FAILED)
+  {
+    error("Couldn't allocate memory shared with portfolio solvers");
+    return smt_convt::P_ERROR;
+  }
+
+  std::atomic<int> *winner = new(mem) std::atomic<int>(-1);
+
+  // Pending alarms are not inherited through fork; pass the remaining
+  // --timeout on to the solver processes
+  unsigned int timeout = alarm(0);
+  alarm(timeout);
+
+  // Don't let the solvers inherit (and print again) buffered output
+  std::cout.flush();
+  fflush(stdout);
+
+  std::vector<pid_t> children_pid;
+  for(unsigned int s = 0; s < solvers.size(); ++s)
+  {
+    pid_t pid = fork();
+
+    if(pid == -1)
+    {
+      status("\nFork Failed, giving up.");
+      for(pid_t i : children_pid)
+        kill(i, SIGKILL);
+      _exit(1);
+    }
+
+    // Solver process: encode and solve the equation, and report the answer
+    // if it is the first one.
+    if(!pid)
+    {
+      solvers_forked_child();
+      alarm(timeout);
+
+      runtime_solver = std::shared_ptr<smt_convt>(create_solver_factory(
+        solvers[s], options.get_bool_option("int-encoding"), ns, options));
+
+      smt_convt::resultt res = run_decision_procedure(runtime_solver, eq);
+
+      if(res == smt_convt::P_SATISFIABLE || res == smt_convt::P_UNSATISFIABLE)
+      {
+        int none = -1;
+        if(
+          winner->compare_exchange_strong(none, s) &&
+          res == smt_convt::P_SATISFIABLE)
+        {
+          report_trace(res, eq);
+
+          if(config.options.get_bool_option("smt-model"))
+            runtime_solver->print_model();
+        }
+      }
+
+      std::cout.flush();
+      fflush(stdout);
+      _exit(res);
+    }
+
+    children_pid.push_back(pid);
+  }
+
+  // Wait for the first solver with a definitive answer; the others are
+  // killed then
+  smt_convt::resultt res = smt_convt::P_ERROR;
+  std::vector<pid_t> running = children_pid;
+  while(!running.empty())
+  {
+    int wstatus;
+    pid_t pid = waitpid(-1, &wstatus, 0);
+    if(pid == -1)
+    {
+      if(errno == EINTR)
+        continue;
+      break;
+    }
+
+    auto it = std::find(running.begin(), running.end(), pid);
+    if(it == running.end())
+      continue;
+    running.erase(it);
+
+    unsigned int s =
+      std::find(children_pid.begin(), children_pid.end(), pid) -
+      children_pid.begin();
+
+    if(!WIFEXITED(wstatus))
+    {
+      std::cout << "**** WARNING: Solver " << solvers[s]
+                << " process crashed." << std::endl;
+      continue;
+    }
+
+    if(winner->load() == int(s))
+    {
+      res = smt_convt::resultt(WEXITSTATUS(wstatus));
+      status("Answer from solver " + solvers[s]);
+
+      for(pid_t i : running)
+        kill(i, SIGKILL);
+    }
+  }
+
+  winner->~atomic<int>();
+  munmap(mem, sizeof(std::atomic<int>));
+
+  return res;
+#endif
+}
+
 smt_convt::resultt bmct::run_thread(std::shared_ptr<symex_target_equationt> &eq)
 {
   std::shared_ptr<goto_symext::symex_resultt> result;
@@ -689,6 +1204,10 @@ smt_convt::resultt bmct::run_thread(std::shared_ptr<symex_target_equationt> &eq)
 
   eq = std::dynamic_pointer_cast<symex_target_equationt>(result->target);
 
+  // Checked by another --parallel-interleavings worker
+  if(!symex->owns_current_interleaving())
+    return smt_convt::P_UNSATISFIABLE;
+
   {
     std::ostringstream str;
     str << "Symex completed in: ";
@@ -698,6 +1217,27 @@ smt_convt::resultt bmct::run_thread(std::shared_ptr<symex_target_equationt> &eq)
     status(str.str());
   }
 
+  if(options.get_bool_option("smt-symex-guard"))
+  {
+    const goto_symext::guard_statst &stats = goto_symext::guard_stats;
+    std::ostringstream str;
+    str << "Branch guards checked: " << stats.checked << " ("
+        << stats.by_path << " decided by the path guard, " << stats.by_solver
+        << " of " << stats.solver_queries << " solver queries decided, "
+        << stats.over_budget << " over budget)\n";
+    str << "Branch guard solver time: ";
+    output_time(stats.solver_time, str);
+    str << "s";
+    print(8, str.str());
+  }
+
+  {
+    std::ostringstream str;
+    str << "Simplifier cache: " << simplify_cache.hits << " hits, "
+        << simplify_cache.misses << " misses";
+    print(8, str.str());
+  }
+
   if(options.get_bool_option("double-assign-check"))
     eq->check_for_duplicate_assigns();
 
@@ -760,7 +1300,33 @@ smt_convt::resultt bmct::run_thread(std::shared_ptr<symex_target_equationt> &eq)
       return smt_convt::P_UNSATISFIABLE;
     }
 
-    if(!options.get_bool_option("smt-during-symex"))
+    if(!options.get_option("portfolio").empty())
+    {
+      smt_convt::resultt res = run_portfolio(eq);
+
+      // The counterexample only exists in the process of the solver that
+      // found it, which has already reported it
+      if(res == smt_convt::P_SATISFIABLE)
+        eq.reset();
+
+      return res;
+    }
+
+    if(options.get_bool_option("slice-per-claim"))
+      return per_claim_check(eq);
+
+    if(incremental != nullptr)
+    {
+      if(!incremental->solver)
+        incremental->solver = std::shared_ptr<smt_convt>(create_solver_factory(
+          "",
+          options.get_bool_option("int-encoding"),
+          incremental->ns,
+          options));
+
+      runtime_solver = incremental->solver;
+    }
+    else if(!options.get_bool_option("smt-during-symex"))
     {
       runtime_solver = std::shared_ptr<smt_convt>(create_solver_factory(
         "", options.get_bool_option("int-encoding"), ns, options));
@@ -19,6 +19,25 @@ Author: Daniel Kroening, kroening@kroening.com
 #include <solvers/solve.h>
 #include <util/options.h>
 
+/* Solver state kept across the bmct runs for increasing bounds of one
+ * k-induction step, with --incremental-solver */
+class incremental_solvert
+{
+public:
+  explicit incremental_solvert(const contextt &context)
+    : ns(context), dynamic_counter(0)
+  {
+  }
+
+  // Outlives the bmct instances, as the solver keeps a reference to it
+  namespacet ns;
+  std::shared_ptr<smt_convt> solver;
+  symex_target_equationt::encoded_prefixt prefix;
+
+  // Dynamic object count when the first bound was explored
+  unsigned int dynamic_counter;
+};
+
 class bmct : public messaget
 {
 public:
@@ -42,6 +61,11 @@ public:
     ui = _ui;
   }
 
+  void set_incremental_solver(incremental_solvert &_incremental)
+  {
+    incremental = &_incremental;
+  }
+
 protected:
   const contextt &context;
   namespacet ns;
@@ -51,10 +75,24 @@ protected:
   // use gui format
   language_uit::uit ui;
 
+  // subtrees claimed by the --parallel-interleavings workers, if any
+  reachability_treet::subtree_claimst *subtree_claims;
+
+  // solver and encoded prefix shared with the other bounds, if any
+  incremental_solvert *incremental;
+
   virtual smt_convt::resultt run_decision_procedure(
     std::shared_ptr<smt_convt> &smt_conv,
     std::shared_ptr<symex_target_equationt> &eq);
 
+  virtual smt_convt::resultt multi_property_check(
+    std::shared_ptr<smt_convt> &smt_conv,
+    std::shared_ptr<symex_target_equationt> &eq,
+    const smt_convt::ast_vec &violations);
+
+  virtual smt_convt::resultt
+  per_claim_check(std::shared_ptr<symex_target_equationt> &eq);
+
   virtual void do_cbmc(
     std::shared_ptr<smt_convt> &smt_conv,
     std::shared_ptr<symex_target_equationt> &eq);
@@ -85,6 +123,15 @@ protected:
     std::shared_ptr<symex_target_equationt> &eq);
 
   smt_convt::resultt run_thread(std::shared_ptr<symex_target_equationt> &eq);
+
+  smt_convt::resultt
+  run_interleavings(std::shared_ptr<symex_target_equationt> &eq);
+
+  smt_convt::resultt
+  run_parallel_interleavings(std::shared_ptr<symex_target_equationt> &eq);
+
+  smt_convt::resultt
+  run_portfolio(std::shared_ptr<symex_target_equationt> &eq);
 };
 
 #endif
@@ -33,6 +33,7 @@ extern "C"
 #include <cstdlib>
 #include <util/expr_util.h>
 #include <fstream>
+#include <list>
 #include <goto-programs/add_race_assertions.h>
 #include <goto-programs/goto_check.h>
 #include <goto-programs/goto_convert_functions.h>
@@ -54,8 +55,10 @@ extern "C"
 #include <pointer-analysis/value_set_analysis.h>
 #include <util/symbol.h>
 #include <util/time_stopping.h>
+#include <vector>
 
 #ifndef _WIN32
+#include <poll.h>
 #include <sys/wait.h>
 #endif
 
@@ -263,6 +266,157 @@ void esbmc_parseoptionst::get_command_line_options(optionst &options)
     }
   }
 
+  if(
+    cmdline.isset("smt-symex-guard-budget") &&
+    !cmdline.isset("smt-symex-guard"))
+  {
+    std::cerr << "--smt-symex-guard-budget requires --smt-symex-guard"
+              << std::endl;
+    abort();
+  }
+
+  if(cmdline.isset("multi-property") && cmdline.isset("smt-during-symex"))
+  {
+    std::cerr << "--multi-property can't be combined with --smt-during-symex"
+              << std::endl;
+    abort();
+  }
+
+  if(cmdline.isset("slice-per-claim"))
+  {
+    if(
+      cmdline.isset("multi-property") || cmdline.isset("smt-during-symex") ||
+      cmdline.isset("incremental-solver") || cmdline.isset("portfolio"))
+    {
+      std::cerr << "--slice-per-claim can't be combined with "
+                   "--multi-property, --smt-during-symex, "
+                   "--incremental-solver or --portfolio"
+                << std::endl;
+      abort();
+    }
+
+    // Each claim gets a converter of its own, which would overwrite the
+    // formula the previous claim's converter wrote
+    if(
+      cmdline.isset("output") &&
+      (cmdline.isset("smtlib") || cmdline.isset("smt-formula-only") ||
+       cmdline.isset("smt-formula-too")))
+    {
+      std::cerr << "--slice-per-claim can't write SMT formulas to an --output "
+                   "file, only the last claim's would be kept"
+                << std::endl;
+      abort();
+    }
+  }
+
+  if(cmdline.isset("parallel-interleavings"))
+  {
+    if(
+      cmdline.isset("schedule") || cmdline.isset("round-robin") ||
+      cmdline.isset("interactive-ileaves") ||
+      cmdline.isset("smt-during-symex"))
+    {
+      std::cerr << "--parallel-interleavings can't be combined with "
+                   "--schedule, --round-robin, --interactive-ileaves or "
+                   "--smt-during-symex"
+                << std::endl;
+      abort();
+    }
+
+    if(atoi(cmdline.getval("parallel-interleavings")) < 1)
+    {
+      std::cerr << "--parallel-interleavings requires at least one worker"
+                << std::endl;
+      abort();
+    }
+
+    // Subtrees are identified by one byte per context switch, see
+    // reachability_treet::get_path_key
+    int depth = atoi(cmdline.getval("parallel-interleavings-depth"));
+    if(depth < 1 || depth > 8)
+    {
+      std::cerr << "--parallel-interleavings-depth must be between 1 and 8"
+                << std::endl;
+      abort();
+    }
+
+    options.set_option("parallel-interleavings-depth", depth);
+  }
+
+  if(
+    cmdline.isset("encoding-threads") &&
+    atoi(cmdline.getval("encoding-threads")) < 1)
+  {
+    std::cerr << "--encoding-threads requires at least one thread"
+              << std::endl;
+    abort();
+  }
+
+  if(cmdline.isset("release-encoded-steps"))
+  {
+    // These read the SSA steps again after they have been encoded
+    if(
+      cmdline.isset("smt-during-symex") ||
+      cmdline.isset("incremental-solver") || cmdline.isset("bidirectional") ||
+      cmdline.isset("slice-per-claim"))
+    {
+      std::cerr << "--release-encoded-steps can't be combined with "
+                   "--smt-during-symex, --incremental-solver, "
+                   "--bidirectional or --slice-per-claim"
+                << std::endl;
+      abort();
+    }
+  }
+
+  if(cmdline.isset("simplify-cache-size"))
+    simplify_cache.set_capacity(atoi(cmdline.getval("simplify-cache-size")));
+
+  if(cmdline.isset("portfolio"))
+  {
+    if(
+      cmdline.isset("multi-property") || cmdline.isset("smt-during-symex") ||
+      cmdline.isset("incremental-solver") || cmdline.isset("bidirectional") ||
+      cmdline.isset("smt-formula-only") || cmdline.isset("smt-formula-too"))
+    {
+      std::cerr << "--portfolio can't be combined with --multi-property, "
+                   "--smt-during-symex, --incremental-solver, "
+                   "--bidirectional, --smt-formula-only or --smt-formula-too"
+                << std::endl;
+      abort();
+    }
+  }
+
+  if(cmdline.isset("incremental-solver"))
+  {
+    if(
+      cmdline.isset("multi-property") || cmdline.isset("smt-during-symex") ||
+      cmdline.isset("k-induction-parallel-jobs"))
+    {
+      std::cerr << "--incremental-solver can't be combined with "
+                   "--multi-property, --smt-during-symex or "
+                   "--k-induction-parallel-jobs"
+                << std::endl;
+      abort();
+    }
+  }
+
+  if(cmdline.isset("k-induction-parallel-jobs"))
+  {
+    if(!cmdline.isset("k-induction-parallel"))
+    {
+      std::cerr << "--k-induction-parallel-jobs requires --k-induction-parallel"
+                << std::endl;
+      abort();
+    }
+
+    if(atoi(cmdline.getval("k-induction-parallel-jobs")) < 1)
+    {
+      std::cerr << "--k-induction-parallel-jobs requires at least one job"
+                << std::endl;
+      abort();
+    }
+  }
+
   if(cmdline.isset("base-case"))
   {
     options.set_option("base-case", true);
@@ -433,16 +587,43 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
   std::cerr << "Windows does not support parallel kind\n";
   abort();
 #else
-  // Pipes for communication between processes
-  int forward_pipe[2], backward_pipe[2];
+  // Build the goto program once, before forking: the children share it
+  // copy-on-write instead of each running the frontend again.
+  optionst opts;
+  get_command_line_options(opts);
+
+  if(get_goto_program(opts, goto_functions))
+    return 6;
+
+  if(cmdline.isset("show-claims"))
+  {
+    const namespacet ns(context);
+    show_claims(ns, get_ui(), goto_functions);
+    return 0;
+  }
+
+  if(set_claims(goto_functions))
+    return 7;
+
+  if(cmdline.isset("k-induction-parallel-jobs"))
+    return doit_k_induction_parallel_jobs(
+      opts, atoi(cmdline.getval("k-induction-parallel-jobs")));
+
+  // Pipes for communication between processes: one per child to send its
+  // result to the parent, so that the parent knows who hung up, and one for
+  // the parent to ask questions to the base case
+  int forward_pipe[3][2], backward_pipe[2];
 
   // Process type
   PROCESS_TYPE process_type = PARENT;
 
-  if(pipe(forward_pipe))
+  for(auto &fds : forward_pipe)
   {
-    status("\nPipe Creation Failed, giving up.");
-    _exit(1);
+    if(pipe(fds))
+    {
+      status("\nPipe Creation Failed, giving up.");
+      _exit(1);
+    }
   }
 
   if(pipe(backward_pipe))
@@ -455,6 +636,14 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
   fcntl(
     backward_pipe[0], F_SETFL, fcntl(backward_pipe[0], F_GETFL) | O_NONBLOCK);
 
+  // Pending alarms are not inherited through fork; pass the remaining
+  // --timeout on to the children
+  unsigned int timeout = alarm(0);
+  alarm(timeout);
+
+  // Don't let the children inherit (and print again) buffered output
+  std::cout.flush();
+
   pid_t children_pid[3];
   short num_p = 0;
 
@@ -472,7 +661,9 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
     // Child process
     if(!pid)
     {
+      solvers_forked_child();
       process_type = PROCESS_TYPE(p);
+      alarm(timeout);
       break;
     }
     // Parent process
@@ -487,26 +678,18 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
     abort();
   }
 
-  optionst opts;
-
+  // Each child only keeps the write end of its own result pipe
+  int result_fd = -1;
   if(process_type != PARENT)
   {
-    // Get full set of options
-    get_command_line_options(opts);
-
-    // Generate goto functions and set claims
-    if(get_goto_program(opts, goto_functions))
-      return 6;
-
-    if(cmdline.isset("show-claims"))
+    for(unsigned p = 0; p < 3; ++p)
     {
-      const namespacet ns(context);
-      show_claims(ns, get_ui(), goto_functions);
-      return 0;
+      close(forward_pipe[p][0]);
+      if(p == unsigned(process_type))
+        result_fd = forward_pipe[p][1];
+      else
+        close(forward_pipe[p][1]);
     }
-
-    if(set_claims(goto_functions))
-      return 7;
   }
 
   // Get max number of iterations
@@ -523,10 +706,18 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
   case PARENT:
   {
     // Communication to child processes
-    close(forward_pipe[1]);
+    struct pollfd fds[3];
+    for(unsigned p = 0; p < 3; ++p)
+    {
+      close(forward_pipe[p][1]);
+      fds[p].fd = forward_pipe[p][0];
+      fds[p].events = POLLIN;
+    }
     close(backward_pipe[0]);
 
-    struct resultt a_result;
+    const char *process_name[3] = {
+      "Base case", "Forward condition", "Inductive step"};
+
     bool bc_finished = false, fc_finished = false, is_finished = false;
     BigInt bc_solution = max_k_step, fc_solution = max_k_step,
            is_solution = max_k_step;
@@ -534,16 +725,37 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
     // Keep reading until we find an answer
     while(!(bc_finished && fc_finished && is_finished))
     {
-      // Perform read and interpret the number of bytes read
-      int read_size = read(forward_pipe[0], &a_result, sizeof(resultt));
-      if(read_size != sizeof(resultt))
+      // Sleep until a child sends its result or hangs up
+      if(poll(fds, 3, -1) == -1)
+      {
+        if(errno == EINTR)
+          continue;
+
+        perror("Couldn't wait for kinduction children");
+        abort();
+      }
+
+      for(unsigned p = 0; p < 3; ++p)
       {
+        if(fds[p].fd == -1 || fds[p].revents == 0)
+          continue;
+
+        // Each child sends a single result, after which it exits
+        struct resultt a_result;
+        int read_size = read(fds[p].fd, &a_result, sizeof(resultt));
+        close(fds[p].fd);
+        fds[p].fd = -1;
+
         if(read_size == 0)
         {
-          // Client hung up; continue on, but don't interpret the result.
-          ;
+          // Hung up without an answer
+          std::cout << "**** WARNING: " << process_name[p]
+                    << " process crashed." << std::endl;
+          bc_finished = fc_finished = is_finished = true;
+          continue;
         }
-        else
+
+        if(read_size != sizeof(resultt))
         {
           // Invalid size read.
           std::cerr << "Short read communicating with kinduction children"
@@ -552,97 +764,31 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
                     << std::endl;
           abort();
         }
-      }
-
-      // Eventually the parent process will check if the child process is alive
-
-      // Check base case process
-      if(!bc_finished)
-      {
-        int status;
-        pid_t result = waitpid(children_pid[0], &status, WNOHANG);
-        if(result == 0)
-        {
-          // Child still alive
-        }
-        else if(result == -1)
-        {
-          // Error
-        }
-        else
-        {
-          std::cout << "**** WARNING: Base case process crashed." << std::endl;
-          bc_finished = fc_finished = is_finished = true;
-        }
-      }
 
-      // Check forward condition process
-      if(!fc_finished)
-      {
-        int status;
-        pid_t result = waitpid(children_pid[1], &status, WNOHANG);
-        if(result == 0)
-        {
-          // Child still alive
-        }
-        else if(result == -1)
-        {
-          // Error
-        }
-        else
+        switch(a_result.type)
         {
-          std::cout << "**** WARNING: Forward condition process crashed."
-                    << std::endl;
+        case BASE_CASE:
+          bc_finished = true;
+          bc_solution = a_result.k;
+          break;
 
-          fc_finished = bc_finished = is_finished = true;
-        }
-      }
+        case FORWARD_CONDITION:
+          fc_finished = true;
+          fc_solution = a_result.k;
+          break;
 
-      // Check inductive step process
-      if(!is_finished)
-      {
-        int status;
-        pid_t result = waitpid(children_pid[2], &status, WNOHANG);
-        if(result == 0)
-        {
-          // Child still alive
-        }
-        else if(result == -1)
-        {
-          // Error
-        }
-        else
-        {
-          std::cout << "**** WARNING: Inductive step process crashed."
-                    << std::endl;
+        case INDUCTIVE_STEP:
+          is_finished = true;
+          is_solution = a_result.k;
+          break;
 
-          is_finished = bc_finished = fc_finished = true;
+        default:
+          std::cerr << "Message from unrecognized k-induction child "
+                    << "process" << std::endl;
+          abort();
         }
       }
 
-      switch(a_result.type)
-      {
-      case BASE_CASE:
-        bc_finished = true;
-        bc_solution = a_result.k;
-        break;
-
-      case FORWARD_CONDITION:
-        fc_finished = true;
-        fc_solution = a_result.k;
-        break;
-
-      case INDUCTIVE_STEP:
-        is_finished = true;
-        is_solution = a_result.k;
-        break;
-
-      default:
-        std::cerr << "Message from unrecognized k-induction child "
-                  << "process" << std::endl;
-        abort();
-      }
-
       // If either the base case found a bug or the forward condition
       // finds a solution, present the result
       if(bc_finished && (bc_solution != 0) && (bc_solution != max_k_step))
@@ -657,8 +803,14 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
         if(bc_finished)
           break;
 
-        // Otherwise, kill the inductive step process
+        // Otherwise, kill the inductive step process, and stop listening to
+        // it so that this isn't mistaken for a crash
         kill(children_pid[2], SIGKILL);
+        if(fds[2].fd != -1)
+        {
+          close(fds[2].fd);
+          fds[2].fd = -1;
+        }
 
         // And ask base case for a solution
 
@@ -679,8 +831,14 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
         if(bc_finished)
           break;
 
-        // Otherwise, kill the forward condition process
+        // Otherwise, kill the forward condition process, and stop listening
+        // to it so that this isn't mistaken for a crash
         kill(children_pid[1], SIGKILL);
+        if(fds[1].fd != -1)
+        {
+          close(fds[1].fd);
+          fds[1].fd = -1;
+        }
 
         // And ask base case for a solution
 
@@ -697,7 +855,10 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
     }
 
     for(int i : children_pid)
+    {
       kill(i, SIGKILL);
+      waitpid(i, nullptr, 0);
+    }
 
     // Check if a solution was found by the base case
     if(bc_finished && (bc_solution != 0) && (bc_solution != max_k_step))
@@ -756,7 +917,6 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
     opts.set_option("partial-loops", false);
 
     // Start communication to the parent process
-    close(forward_pipe[0]);
     close(backward_pipe[1]);
 
     // Struct to keep the result
@@ -770,6 +930,9 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
       bmct bmc(goto_functions, opts, context, ui_message_handler);
       set_verbosity_msg(bmc);
 
+      if(opts.get_bool_option("incremental-solver"))
+        bmc.set_incremental_solver(base_case_solver);
+
       bmc.options.set_option("unwind", integer2string(k_step));
 
       std::cout << "*** Checking base case, k = " << k_step << '\n';
@@ -791,7 +954,7 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
         r.k = k_step.to_uint64();
 
         // Write result
-        auto const len = write(forward_pipe[1], &r, sizeof(r));
+        auto const len = write(result_fd, &r, sizeof(r));
         assert(len == sizeof(r) && "short write");
         (void)len; //ndebug
 
@@ -844,7 +1007,7 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
     // Send information to parent that a bug was not found
     r.k = 0;
 
-    auto const len = write(forward_pipe[1], &r, sizeof(r));
+    auto const len = write(result_fd, &r, sizeof(r));
     assert(len == sizeof(r) && "short write");
     (void)len; //ndebug
 
@@ -864,7 +1027,6 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
     opts.set_option("no-assertions", true);
 
     // Start communication to the parent process
-    close(forward_pipe[0]);
     close(backward_pipe[1]);
 
     // Struct to keep the result
@@ -878,6 +1040,9 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
       bmct bmc(goto_functions, opts, context, ui_message_handler);
       set_verbosity_msg(bmc);
 
+      if(opts.get_bool_option("incremental-solver"))
+        bmc.set_incremental_solver(forward_condition_solver);
+
       bmc.options.set_option("unwind", integer2string(k_step));
 
       std::cout << "*** Checking forward condition, k = " << k_step << '\n';
@@ -902,7 +1067,7 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
         r.k = k_step.to_uint64();
 
         // Write result
-        auto const len = write(forward_pipe[1], &r, sizeof(r));
+        auto const len = write(result_fd, &r, sizeof(r));
         assert(len == sizeof(r) && "short write");
         (void)len; //ndebug
 
@@ -914,7 +1079,7 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
     // Send information to parent that it couldn't prove the code
     r.k = 0;
 
-    auto const len = write(forward_pipe[1], &r, sizeof(r));
+    auto const len = write(result_fd, &r, sizeof(r));
     assert(len == sizeof(r) && "short write");
     (void)len; //ndebug
 
@@ -933,7 +1098,6 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
     opts.set_option("partial-loops", true);
 
     // Start communication to the parent process
-    close(forward_pipe[0]);
     close(backward_pipe[1]);
 
     // Struct to keep the result
@@ -947,6 +1111,9 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
       bmct bmc(goto_functions, opts, context, ui_message_handler);
       set_verbosity_msg(bmc);
 
+      if(opts.get_bool_option("incremental-solver"))
+        bmc.set_incremental_solver(inductive_step_solver);
+
       bmc.options.set_option("unwind", integer2string(k_step));
 
       std::cout << "*** Checking inductive step, k = " << k_step << '\n';
@@ -971,7 +1138,7 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
         r.k = k_step.to_uint64();
 
         // Write result
-        auto const len = write(forward_pipe[1], &r, sizeof(r));
+        auto const len = write(result_fd, &r, sizeof(r));
         assert(len == sizeof(r) && "short write");
         (void)len; //ndebug
 
@@ -983,7 +1150,7 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
     // Send information to parent that it couldn't prove the code
     r.k = 0;
 
-    auto const len = write(forward_pipe[1], &r, sizeof(r));
+    auto const len = write(result_fd, &r, sizeof(r));
     assert(len == sizeof(r) && "short write");
     (void)len; //ndebug
 
@@ -1000,6 +1167,306 @@ int esbmc_parseoptionst::doit_k_induction_parallel()
   return 0;
 }
 
+int esbmc_parseoptionst::doit_k_induction_parallel_jobs(
+  optionst &opts,
+  unsigned int jobs)
+{
+#ifdef _WIN32
+  std::cerr << "Windows does not support parallel kind\n";
+  abort();
+#else
+  // Get max number of iterations
+  uint64_t max_k_step = cmdline.isset("unlimited-k-steps")
+                          ? UINT_MAX
+                          : strtoul(cmdline.getval("max-k-step"), nullptr, 10);
+
+  // Get the increment
+  unsigned k_step_inc = strtoul(cmdline.getval("k-step"), nullptr, 10);
+
+  uint64_t max_inductive_step =
+    strtoul(cmdline.getval("max-inductive-step"), nullptr, 10);
+
+  // Pending alarms are not inherited through fork; pass the remaining
+  // --timeout on to the children
+  unsigned int timeout = alarm(0);
+  alarm(timeout);
+
+  const char *process_name[3] = {
+    "Base case", "Forward condition", "Inductive step"};
+
+  // A (step, k) pair being checked by a child process, and the pipe the
+  // child sends its resultt on. The child sends back k if the base case
+  // found a bug or the other steps found a proof, and 0 otherwise
+  struct jobt
+  {
+    resultt task;
+    pid_t pid;
+    int fd;
+  };
+
+  std::vector<jobt> running;
+  std::list<resultt> pending;
+
+  // The next k to hand out
+  uint64_t next_k = 1;
+
+  // Smallest k where the base case found a bug
+  uint64_t bug_k = 0;
+
+  // Smallest k where the forward condition or inductive step found a proof
+  resultt proof = {PARENT, 0};
+
+  // Largest k where the base case finished without finding a bug. A proof
+  // for k only holds once the base case is known to be safe up to k
+  uint64_t safe_k = 0;
+
+  auto const stop_job = [](const jobt &job) {
+    kill(job.pid, SIGKILL);
+    close(job.fd);
+    waitpid(job.pid, nullptr, 0);
+  };
+
+  while(true)
+  {
+    // Hand out (step, k) pairs while there are free job slots; no new
+    // depths are started once a bug or a proof was found
+    while(running.size() < jobs)
+    {
+      if(pending.empty() && !bug_k && !proof.k && next_k <= max_k_step)
+      {
+        pending.push_back({BASE_CASE, next_k});
+
+        if(!opts.get_bool_option("disable-forward-condition"))
+          pending.push_back({FORWARD_CONDITION, next_k});
+
+        // Don't run inductive step for k_step == 1
+        if(
+          next_k > 1 && next_k <= max_inductive_step &&
+          !opts.get_bool_option("disable-inductive-step"))
+          pending.push_back({INDUCTIVE_STEP, next_k});
+
+        next_k += k_step_inc;
+      }
+
+      if(pending.empty())
+        break;
+
+      resultt task = pending.front();
+      pending.pop_front();
+
+      int result_pipe[2];
+      if(pipe(result_pipe))
+      {
+        status("\nPipe Creation Failed, giving up.");
+        _exit(1);
+      }
+
+      // Don't let the child inherit (and print again) buffered output
+      std::cout.flush();
+
+      pid_t pid = fork();
+      if(pid == -1)
+      {
+        status("\nFork Failed, giving up.");
+        _exit(1);
+      }
+
+      // Child process: check a single step and report back
+      if(!pid)
+      {
+        close(result_pipe[0]);
+        for(auto const &job : running)
+          close(job.fd);
+        solvers_forked_child();
+
+        alarm(timeout);
+
+        struct resultt r = task;
+        BigInt k_step = task.k;
+
+        // If an exception was thrown, report that nothing was found
+        bool found = false;
+        try
+        {
+          switch(task.type)
+          {
+          case BASE_CASE:
+            found = do_base_case(opts, goto_functions, k_step);
+            break;
+
+          case FORWARD_CONDITION:
+            found = !do_forward_condition(opts, goto_functions, k_step);
+            break;
+
+          case INDUCTIVE_STEP:
+            found = !do_inductive_step(opts, goto_functions, k_step);
+            break;
+
+          default:
+            assert(0 && "Unknown process type.");
+          }
+        }
+        catch(...)
+        {
+        }
+
+        if(!found)
+          r.k = 0;
+
+        auto const len = write(result_pipe[1], &r, sizeof(r));
+        assert(len == sizeof(r) && "short write");
+        (void)len; //ndebug
+
+        std::cout.flush();
+        _exit(0);
+      }
+
+      close(result_pipe[1]);
+      running.push_back({task, pid, result_pipe[0]});
+    }
+
+    if(running.empty())
+      break;
+
+    // Sleep until some child sends its result or hangs up
+    std::vector<struct pollfd> fds(running.size());
+    for(unsigned i = 0; i < running.size(); ++i)
+    {
+      fds[i].fd = running[i].fd;
+      fds[i].events = POLLIN;
+      fds[i].revents = 0;
+    }
+
+    if(poll(fds.data(), fds.size(), -1) == -1)
+    {
+      if(errno == EINTR)
+        continue;
+
+      perror("Couldn't wait for kinduction children");
+      abort();
+    }
+
+    std::vector<jobt> still_running;
+    for(unsigned i = 0; i < running.size(); ++i)
+    {
+      const jobt &job = running[i];
+      if(fds[i].revents == 0)
+      {
+        still_running.push_back(job);
+        continue;
+      }
+
+      struct resultt a_result;
+      int read_size = read(job.fd, &a_result, sizeof(resultt));
+      close(job.fd);
+      waitpid(job.pid, nullptr, 0);
+
+      if(read_size == 0)
+      {
+        // Hung up without an answer; whatever it was checking stays unknown
+        std::cout << "**** WARNING: " << process_name[job.task.type]
+                  << " process crashed (k = " << job.task.k << ")."
+                  << std::endl;
+        continue;
+      }
+
+      if(read_size != sizeof(resultt))
+      {
+        // Invalid size read.
+        std::cerr << "Short read communicating with kinduction children"
+                  << std::endl;
+        std::cerr << "Size " << read_size << ", expected " << sizeof(resultt)
+                  << std::endl;
+        abort();
+      }
+
+      switch(a_result.type)
+      {
+      case BASE_CASE:
+        if(a_result.k == 0)
+          safe_k = std::max(safe_k, job.task.k);
+        else if(!bug_k || a_result.k < bug_k)
+          bug_k = a_result.k;
+        break;
+
+      case FORWARD_CONDITION:
+      case INDUCTIVE_STEP:
+        if(a_result.k != 0 && (!proof.k || a_result.k < proof.k))
+          proof = a_result;
+        break;
+
+      default:
+        std::cerr << "Message from unrecognized k-induction child "
+                  << "process" << std::endl;
+        abort();
+      }
+    }
+    running.swap(still_running);
+
+    // A proof backed by a safe base case settles it: stop everything
+    if(!bug_k && proof.k && safe_k >= proof.k)
+      break;
+
+    // Once a bug was found only the base cases for smaller k, which may
+    // give a shorter counterexample, are still of interest. Once a proof was
+    // found, only the base cases up to its k are needed to validate it
+    if(!bug_k && !proof.k)
+      continue;
+
+    auto const still_needed = [bug_k, proof](const resultt &task) {
+      return task.type == BASE_CASE &&
+             (bug_k ? task.k < bug_k : task.k <= proof.k);
+    };
+
+    pending.remove_if(
+      [&still_needed](const resultt &task) { return !still_needed(task); });
+
+    still_running.clear();
+    for(auto const &job : running)
+    {
+      if(still_needed(job.task))
+        still_running.push_back(job);
+      else
+        stop_job(job);
+    }
+    running.swap(still_running);
+  }
+
+  for(auto const &job : running)
+    stop_job(job);
+
+  // Check if a solution was found by the base case
+  if(bug_k)
+  {
+    std::cout << std::endl
+              << "Bug found by the base case (k = " << bug_k << ")"
+              << std::endl;
+    std::cout << "VERIFICATION FAILED" << std::endl;
+    return true;
+  }
+
+  // Check if a solution was found by the forward condition or the inductive
+  // step, and the base case is safe up to it
+  if(proof.k && safe_k >= proof.k)
+  {
+    std::cout << std::endl;
+    if(proof.type == FORWARD_CONDITION)
+      std::cout << "Solution found by the forward condition; "
+                << "all states are reachable (k = " << proof.k << ")"
+                << std::endl;
+    else
+      std::cout << "Solution found by the inductive step "
+                << "(k = " << proof.k << ")" << std::endl;
+    std::cout << "VERIFICATION SUCCESSFUL" << std::endl;
+    return false;
+  }
+
+  // Couldn't find a bug or a proof for the current deepth
+  std::cout << std::endl << "VERIFICATION UNKNOWN" << std::endl;
+  return false;
+#endif
+}
+
 int esbmc_parseoptionst::doit_k_induction()
 {
   optionst opts;
@@ -1181,6 +1648,9 @@ int esbmc_parseoptionst::do_base_case(
   bmct bmc(goto_functions, opts, context, ui_message_handler);
   set_verbosity_msg(bmc);
 
+  if(opts.get_bool_option("incremental-solver"))
+    bmc.set_incremental_solver(base_case_solver);
+
   bmc.options.set_option("unwind", integer2string(k_step));
 
   std::cout << "*** Checking base case, k = " << k_step << '\n';
@@ -1228,6 +1698,9 @@ int esbmc_parseoptionst::do_forward_condition(
   bmct bmc(goto_functions, opts, context, ui_message_handler);
   set_verbosity_msg(bmc);
 
+  if(opts.get_bool_option("incremental-solver"))
+    bmc.set_incremental_solver(forward_condition_solver);
+
   bmc.options.set_option("unwind", integer2string(k_step));
 
   std::cout << "*** Checking forward condition, k = " << k_step << '\n';
@@ -1283,6 +1756,9 @@ int esbmc_parseoptionst::do_inductive_step(
   bmct bmc(goto_functions, opts, context, ui_message_handler);
   set_verbosity_msg(bmc);
 
+  if(opts.get_bool_option("incremental-solver"))
+    bmc.set_incremental_solver(inductive_step_solver);
+
   bmc.options.set_option("unwind", integer2string(k_step));
 
   std::cout << "*** Checking inductive step, k = " << k_step << '\n';
@@ -1737,6 +2213,11 @@ void esbmc_parseoptionst::help()
        " --no-unwinding-assertions    do not generate unwinding assertions\n"
        " --partial-loops              permit paths with partial loops\n"
        " --no-slice                   do not remove unused equations\n"
+       " --multi-property             report the status of every claim "
+       "after a single encoding\n"
+       " --slice-per-claim            check every claim on its own, sliced to "
+       "its cone of\n"
+       "                              influence\n"
        " --extended-try-analysis      check all the try block, even when an "
        "exception is thrown\n"
 
@@ -1746,6 +2227,9 @@ void esbmc_parseoptionst::help()
        " --incremental-bmc            incremental loop unwinding verification\n"
        " --termination                incremental loop unwinding assertion "
        "verification\n"
+       " --incremental-solver         keep the solver across k, encoding only "
+       "the SSA steps\n"
+       "                              not shared with the previous k\n"
        " --k-step nr                  set k increment (default is 1)\n"
        " --max-k-step nr              set max number of iteration (default is "
        "50)\n"
@@ -1758,12 +2242,18 @@ void esbmc_parseoptionst::help()
        " --mathsat                    use MathSAT\n"
        " --cvc                        use CVC4\n"
        " --yices                      use Yices\n"
+       " --portfolio solvers          run the comma-separated solvers in "
+       "parallel, e.g.\n"
+       "                              z3,boolector,yices, and take the first "
+       "answer\n"
        " --bv                         use solver with bit-vector arithmetic\n"
        " --ir                         use solver with integer/real arithmetic\n"
        " --smtlib                     use SMT lib format\n"
        " --smtlib-solver-prog         SMT lib program name\n"
        " --output <filename>          output VCCs in SMT lib format to given "
        "file\n"
+       "                              (compressed with zstd if it ends in "
+       ".zst)\n"
        " --fixedbv                    encode floating-point as fixed "
        "bit-vectors\n"
        " --floatbv                    encode floating-point using the SMT "
@@ -1778,6 +2268,11 @@ void esbmc_parseoptionst::help()
        "--tuple-sym-flattener         encode tuples using our tuple to symbol "
        "API\n"
        "--array-flattener             encode arrays using our array API\n"
+       " --encoding-threads nr        hash the VCCs on nr threads before "
+       "encoding them\n"
+       " --release-encoded-steps      free the expressions of each SSA step "
+       "once encoded,\n"
+       "                              keeping what counterexamples need\n"
        "--no-return-value-opt         disable return value optimization to "
        "compute the stack size\n"
 
@@ -1788,6 +2283,8 @@ void esbmc_parseoptionst::help()
        "exploration (experimental)\n"
        " --smt-symex-guard            call the solver during symbolic "
        "execution (experimental)\n"
+       " --smt-symex-guard-budget nr  call the solver at most nr times for "
+       "--smt-symex-guard\n"
 
        "\nProperty checking\n"
        " --no-assertions              ignore assertions\n"
@@ -1819,6 +2316,14 @@ void esbmc_parseoptionst::help()
        " --k-induction-parallel       prove by k-induction, running each step "
        "on a separate\n"
        "                              process\n"
+       " --k-induction-parallel-jobs nr\n"
+       "                              with --k-induction-parallel, check up "
+       "to nr (step, k)\n"
+       "                              pairs at once instead of one process "
+       "per step\n"
+       " --incremental-solver         keep the solver across k, encoding only "
+       "the SSA steps\n"
+       "                              not shared with the previous k\n"
        " --k-step nr                  set k increment (default is 1)\n"
        " --max-k-step nr              set max number of iteration (default is "
        "50)\n"
@@ -1841,6 +2346,12 @@ void esbmc_parseoptionst::help()
        " --no-por                     do not do partial order reduction\n"
        " --all-runs                   check all interleavings, even if a bug "
        "was already found\n"
+       " --parallel-interleavings nr  explore interleavings using nr worker "
+       "processes\n"
+       " --parallel-interleavings-depth nr\n"
+       "                              split interleavings between workers at "
+       "context switch\n"
+       "                              nr (default is 3)\n"
 
        "\nMiscellaneous options\n"
        " --memlimit                   configure memory limit, of form \"100m\" "
@@ -1849,6 +2360,10 @@ void esbmc_parseoptionst::help()
        "by {s,m,h}\n"
        " --memstats                   print memory usage statistics\n"
        " --no-simplify                do not simplify any expression\n"
+       " --simplify-cache-size nr     remember the simplification of up to nr "
+       "expressions\n"
+       "                              (default is 65536, 0 disables the "
+       "cache)\n"
        " --no-propagation             disable constant propagation\n"
        " --enable-core-dump           do not disable core dump output\n"
        " --interval-analysis          enable interval analysis and add assumes "
@@ -26,7 +26,11 @@ public:
   void help() override;
 
   esbmc_parseoptionst(int argc, const char **argv)
-    : parseoptions_baset(esbmc_options, argc, argv), language_uit(cmdline)
+    : parseoptions_baset(esbmc_options, argc, argv),
+      language_uit(cmdline),
+      base_case_solver(context),
+      forward_condition_solver(context),
+      inductive_step_solver(context)
   {
   }
 
@@ -42,6 +46,7 @@ protected:
 
   int doit_k_induction();
   int doit_k_induction_parallel();
+  int doit_k_induction_parallel_jobs(optionst &opts, unsigned int jobs);
 
   int doit_falsification();
   int doit_incremental();
@@ -75,6 +80,11 @@ protected:
 
   void print_ileave_points(namespacet &ns, goto_functionst &goto_functions);
 
+  // Solvers kept across bounds by --incremental-solver, one per step
+  incremental_solvert base_case_solver;
+  incremental_solvert forward_condition_solver;
+  incremental_solvert inductive_step_solver;
+
 public:
   goto_functionst goto_functions;
 };
@@ -79,6 +79,8 @@ const struct opt_templ esbmc_options[] = {
   {0, "partial-loops", switc, ""},
   {0, "unroll-loops", switc, ""},
   {0, "no-slice", switc, ""},
+  {0, "multi-property", switc, ""},
+  {0, "slice-per-claim", switc, ""},
   {0, "slice-assumes", switc, ""},
   {0, "extended-try-analysis", switc, ""},
   {0, "skip-bmc", switc, ""},
@@ -96,6 +98,7 @@ const struct opt_templ esbmc_options[] = {
   {0, "mathsat", switc, ""},
   {0, "cvc", switc, ""},
   {0, "yices", switc, ""},
+  {0, "portfolio", string, ""},
   {0, "bv", switc, ""},
   {0, "ir", switc, ""},
   {0, "smtlib", switc, ""},
@@ -107,11 +110,14 @@ const struct opt_templ esbmc_options[] = {
   {0, "tuple-node-flattener", switc, ""},
   {0, "tuple-sym-flattener", switc, ""},
   {0, "array-flattener", switc, ""},
+  {0, "encoding-threads", number, ""},
+  {0, "release-encoded-steps", switc, ""},
 
   // Incremental SMT
   {0, "smt-during-symex", switc, ""},
   {0, "smt-thread-guard", switc, ""},
   {0, "smt-symex-guard", switc, ""},
+  {0, "smt-symex-guard-budget", number, ""},
 
   // Property checking
   {0, "no-assertions", switc, ""},
@@ -137,6 +143,8 @@ const struct opt_templ esbmc_options[] = {
   {0, "inductive-step", switc, ""},
   {0, "k-induction", switc, ""},
   {0, "k-induction-parallel", switc, ""},
+  {0, "k-induction-parallel-jobs", number, ""},
+  {0, "incremental-solver", switc, ""},
   {0, "k-step", number, "1"},
   {0, "max-k-step", number, "50"},
   {0, "unlimited-k-steps", switc, ""},
@@ -154,6 +162,8 @@ const struct opt_templ esbmc_options[] = {
   {0, "state-hashing", switc, ""},
   {0, "no-por", switc, ""},
   {0, "all-runs", switc, ""},
+  {0, "parallel-interleavings", number, ""},
+  {0, "parallel-interleavings-depth", number, "3"},
 
   // Miscellaneous
   {0, "memlimit", string, ""},
@@ -161,6 +171,7 @@ const struct opt_templ esbmc_options[] = {
   {0, "timeout", string, ""},
   {0, "enable-core-dump", switc, ""},
   {0, "no-simplify", switc, ""},
+  {0, "simplify-cache-size", number, ""},
   {0, "no-propagation", switc, ""},
   {0, "interval-analysis", switc, ""},
 
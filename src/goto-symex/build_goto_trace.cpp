@@ -69,13 +69,11 @@ void build_goto_trace(
 
     goto_trace_step.thread_nr = SSA_step.source.thread_nr;
     goto_trace_step.pc = SSA_step.source.pc;
-    goto_trace_step.comment = SSA_step.comment;
+    goto_trace_step.comment = id2string(SSA_step.comment);
     goto_trace_step.original_lhs = SSA_step.original_lhs;
     goto_trace_step.type = SSA_step.type;
     goto_trace_step.step_nr = ++step_nr;
-    goto_trace_step.format_string = SSA_step.format_string;
-
-    goto_trace_step.stack_trace = SSA_step.stack_trace;
+    goto_trace_step.stack_trace = target->get_stack_trace(SSA_step);
 
     if(SSA_step.is_assignment())
     {
@@ -97,7 +95,10 @@ void build_goto_trace(
 
     if(SSA_step.is_output())
     {
-      for(const auto &arg : SSA_step.converted_output_args)
+      const symex_target_equationt::SSA_outputt &out =
+        target->get_output(SSA_step);
+      goto_trace_step.format_string = out.format_string;
+      for(const auto &arg : out.converted_output_args)
       {
         if(is_constant_expr(arg))
           goto_trace_step.output_args.push_back(arg);
@@ -139,12 +140,11 @@ void build_successful_goto_trace(
       goto_trace_step.lhs = it->lhs;
       goto_trace_step.rhs = it->rhs;
       goto_trace_step.pc = it->source.pc;
-      goto_trace_step.comment = it->comment;
+      goto_trace_step.comment = id2string(it->comment);
       goto_trace_step.original_lhs = it->original_lhs;
       goto_trace_step.type = it->type;
       goto_trace_step.step_nr = step_nr++;
-      goto_trace_step.format_string = it->format_string;
-      goto_trace_step.stack_trace = it->stack_trace;
+      goto_trace_step.stack_trace = target->get_stack_trace(*it);
     }
   }
 }
@@ -1041,36 +1041,31 @@ bool execution_statet::can_execution_continue() const
   return true;
 }
 
-crypto_hash execution_statet::generate_hash() const
+state_hasht execution_statet::generate_hash() const
 {
   auto l2 = std::dynamic_pointer_cast<state_hashing_level2t>(state_level2);
   assert(l2 != nullptr);
 
-  crypto_hash state = l2->generate_l2_state_hash();
-  std::string str = state.to_string();
+  const state_hasht &state = l2->generate_l2_state_hash();
+
+  state_hashert h;
+  h.ingest(&state.h1, sizeof(state.h1));
+  h.ingest(&state.h2, sizeof(state.h2));
 
   for(const auto &it : threads_state)
   {
-    goto_programt::const_targett pc = it.source.pc;
-    int id = pc->location_number;
-    std::stringstream s;
-    s << id;
-    str += "!" + s.str();
+    unsigned int id = it.source.pc->location_number;
+    h.ingest(&id, sizeof(id));
   }
 
-  crypto_hash h;
-  h.ingest(str.c_str(), str.size());
-  h.fin();
-
-  return h;
+  return h.fin();
 }
 
-crypto_hash execution_statet::update_hash_for_assignment(const expr2tc &rhs)
+state_hasht execution_statet::update_hash_for_assignment(const expr2tc &rhs)
 {
-  crypto_hash h;
+  state_hashert h;
   rhs->hash(h);
-  h.fin();
-  return h;
+  return h.fin();
 }
 
 void execution_statet::print_stack_traces(unsigned int indent) const
@@ -1263,40 +1258,25 @@ void execution_statet::state_hashing_level2t::make_assignment(
   const expr2tc &const_value,
   const expr2tc &assigned_value)
 {
-  //  crypto_hash hash;
-
   renaming::level2t::make_assignment(lhs_sym, const_value, assigned_value);
 
   // If there's no body to the assignment, don't hash.
   if(!is_nil_expr(assigned_value))
   {
     // XXX - consider whether to use l1 names instead. Recursion, reentrancy.
-    crypto_hash hash = owner->update_hash_for_assignment(assigned_value);
-    std::string orig_name = to_symbol2t(lhs_sym).thename.as_string();
-    current_hashes[orig_name] = hash;
+    const irep_idt &orig_name = to_symbol2t(lhs_sym).thename;
+    state_hasht value = owner->update_hash_for_assignment(assigned_value);
+
+    // Bind the value to the variable, so that swapping two variables' values
+    // doesn't cancel out in the xor.
+    state_hashert h;
+    h.ingest(orig_name.as_string().c_str(), orig_name.as_string().size());
+    h.ingest(&value.h1, sizeof(value.h1));
+    h.ingest(&value.h2, sizeof(value.h2));
+
+    state_hasht &contrib = current_hashes[orig_name];
+    l2_state_hash ^= contrib;
+    contrib = h.fin();
+    l2_state_hash ^= contrib;
   }
 }
-
-crypto_hash
-execution_statet::state_hashing_level2t::generate_l2_state_hash() const
-{
-  unsigned int total;
-
-  uint8_t *data = (uint8_t *)alloca(
-    current_hashes.size() * CRYPTO_HASH_SIZE * sizeof(uint8_t));
-
-  total = 0;
-  for(const auto &current_hashe : current_hashes)
-  {
-    memcpy(
-      &data[total * CRYPTO_HASH_SIZE],
-      current_hashe.second.hash,
-      CRYPTO_HASH_SIZE);
-    total++;
-  }
-
-  crypto_hash c;
-  c.ingest(data, total * CRYPTO_HASH_SIZE);
-  c.fin();
-  return c;
-}
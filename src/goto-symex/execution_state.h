@@ -121,6 +121,8 @@ public:
    *  State-hashing level2t.
    *  When using this level2t, any assignment made is caught, and the symbolic
    *  names are hashed. This is the primary handler for state hashing.
+   *  The l2 state hash is the xor of one hash per variable, so an assignment
+   *  updates it in constant time by swapping that variable's contribution.
    */
   class state_hashing_level2t : public ex_state_level2t
   {
@@ -132,9 +134,15 @@ public:
       expr2tc &lhs_symbol,
       const expr2tc &const_value,
       const expr2tc &assigned_value) override;
-    crypto_hash generate_l2_state_hash() const;
-    typedef std::map<irep_idt, crypto_hash> current_state_hashest;
+    const state_hasht &generate_l2_state_hash() const
+    {
+      return l2_state_hash;
+    }
+
+    typedef std::unordered_map<irep_idt, state_hasht, irep_id_hash>
+      current_state_hashest;
     current_state_hashest current_hashes;
+    state_hasht l2_state_hash;
   };
 
   // Macros
@@ -282,6 +290,17 @@ public:
   /** Like get_dynamic_counter, but with nondet symbols. */
   unsigned int &get_nondet_counter() override;
 
+  /**
+   *  Fetch reference to the count of dynamic objects shared by all execution
+   *  states. Rewound by --incremental-solver so that each bound names its
+   *  dynamic objects and nondet symbols the same way.
+   *  @return Reference to the count of global dynamic objects.
+   */
+  static unsigned int &global_dynamic_counter()
+  {
+    return dynamic_counter;
+  }
+
   /**
    *  Fetch name of current execution guard.
    *  The execution guard being the guard of the interleavings up to this point
@@ -470,20 +489,20 @@ public:
 
   /**
    *  Generate hash of entire execution state.
-   *  This takes all current symbolic assignments to variables contained in the
-   *  l2 renaming object, and their precomputed hashes, concatonates them with
-   *  the current program counter of each thread, and hashes that. This results
-   *  in a full hash of the current execution state.
+   *  This takes the hash of all current symbolic assignments maintained by
+   *  the l2 renaming object, and hashes it together with the current program
+   *  counter of each thread. This results in a full hash of the current
+   *  execution state.
    *  @return Hash of entire current execution state.
    */
-  crypto_hash generate_hash() const;
+  state_hasht generate_hash() const;
 
   /**
    *  Generate hash of an expression.
    *  @param rhs Expression to hash.
    *  @return Hash of passed in expression.
    */
-  crypto_hash update_hash_for_assignment(const expr2tc &rhs);
+  state_hasht update_hash_for_assignment(const expr2tc &rhs);
 
   /**
    *  Print stack trace of each thread to stdout.
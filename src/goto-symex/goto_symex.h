@@ -15,10 +15,13 @@ Author: Daniel Kroening, kroening@kroening.com
 #include <map>
 #include <pointer-analysis/dereference.h>
 #include <stack>
+#include <unordered_map>
 #include <util/i2string.h>
 #include <util/irep2.h>
 #include <util/options.h>
 #include <util/std_types.h>
+#include <util/threeval.h>
+#include <util/time_stopping.h>
 
 class reachability_treet; // Forward dec
 class execution_statet;   // Forward dec
@@ -56,6 +59,34 @@ public:
   // Types
 
 public:
+  /** Counters for --smt-symex-guard, summed over all symex instances */
+  class guard_statst
+  {
+  public:
+    guard_statst()
+      : checked(0),
+        by_path(0),
+        solver_queries(0),
+        by_solver(0),
+        over_budget(0),
+        solver_time(0)
+    {
+    }
+
+    // Branch guards looked at
+    unsigned int checked;
+    // Decided from what the path guard says
+    unsigned int by_path;
+    // Solver calls, and how many of them were conclusive
+    unsigned int solver_queries;
+    unsigned int by_solver;
+    // Left undecided as the solver budget was spent
+    unsigned int over_budget;
+    fine_timet solver_time;
+  };
+
+  static guard_statst guard_stats;
+
   /** Records for dynamically allocated blobs of memory. */
   class allocated_obj
   {
@@ -182,6 +213,16 @@ protected:
    */
   virtual void symex_goto(const expr2tc &old_guard);
 
+  /**
+   *  Decide whether a renamed branch guard always holds or always fails on
+   *  the current path, for --smt-symex-guard. Checks what the literals of
+   *  the path guard say about it first, and only asks the solver when that
+   *  is inconclusive and the --smt-symex-guard-budget allows.
+   *  @param new_guard Renamed and simplified branch guard.
+   *  @return Truth of new_guard on the current path, if known.
+   */
+  tvt decide_branch_guard(const expr2tc &new_guard);
+
   /**
    *  Perform interpretation of RETURN instruction.
    *  @param code return statement.
@@ -836,6 +877,15 @@ protected:
   /** Flag as to whether we're doing a k-induction inductive step.
    *  Corresponds to the option --inductive-step */
   bool inductive_step;
+  /** Flag as to whether we're pruning infeasible branches. Corresponds to
+   *  the option --smt-symex-guard */
+  bool smt_symex_guard;
+  /** Number of solver calls --smt-symex-guard may make, over all symex
+   *  instances. Corresponds to the option --smt-symex-guard-budget */
+  unsigned long guard_solver_budget;
+  /** Renamed branch guard symbols and the expressions assigned to them, so
+   *  that --smt-symex-guard can see what the path guard's literals mean */
+  std::unordered_map<expr2tc, expr2tc, irep2_hash> guard_definitions;
   /** Set of dereference state records; this field is used as a mailbox between
    *  the dereference code and the caller, who will inspect the contents after
    *  a call to dereference (in INTERNAL mode) completes. */
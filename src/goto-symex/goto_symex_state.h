@@ -21,7 +21,7 @@
 #include <stack>
 #include <string>
 #include <unordered_set>
-#include <util/crypto_hash.h>
+#include <util/state_hash.h>
 #include <util/guard.h>
 #include <util/i2string.h>
 #include <util/irep2.h>
@@ -106,6 +106,8 @@ public:
     guardt guard;
     unsigned int thread_id;
     variable_name_sett local_variables;
+    /** Position in the l2 assignment log when this state was saved */
+    size_t write_mark;
 
     explicit goto_statet(const goto_symex_statet &s)
       : depth(s.depth),
@@ -114,7 +116,8 @@ public:
         value_set(s.value_set),
         guard(s.guard),
         thread_id(s.source.thread_nr),
-        local_variables(s.top().local_variables)
+        local_variables(s.top().local_variables),
+        write_mark(s.level2.get_write_mark())
     {
     }
 
@@ -125,7 +128,8 @@ public:
         value_set(s.value_set),
         guard(s.guard),
         thread_id(s.thread_id),
-        local_variables(s.local_variables)
+        local_variables(s.local_variables),
+        write_mark(s.write_mark)
     {
     }
 
@@ -18,7 +18,7 @@ Author: Lucas Cordeiro, lcc08r@ecs.soton.ac.uk
 #include <goto-symex/goto_symex.h>
 #include <goto-symex/reachability_tree.h>
 #include <util/config.h>
-#include <util/crypto_hash.h>
+#include <util/state_hash.h>
 #include <util/expr_util.h>
 #include <util/i2string.h>
 #include <util/message.h>
@@ -35,7 +35,11 @@ reachability_treet::reachability_treet(
     permanent_context(context),
     ns(ns),
     options(opts),
-    message_handler(_message_handler)
+    message_handler(_message_handler),
+    subtree_claims(nullptr),
+    claim_worker(0),
+    claim_depth(0),
+    claim_skipped_all(false)
 {
   // Put a few useful symbols in the symbol table.
   symbolt sym;
@@ -127,12 +131,7 @@ bool reachability_treet::check_for_hash_collision() const
 {
   const execution_statet &ex_state = get_cur_state();
 
-  crypto_hash hash;
-  hash = ex_state.generate_hash();
-  if(hit_hashes.find(hash) != hit_hashes.end())
-    return true;
-
-  return false;
+  return hit_hashes.contains(ex_state.generate_hash());
 }
 
 void reachability_treet::post_hash_collision_cleanup()
@@ -145,9 +144,7 @@ void reachability_treet::update_hash_collision_set()
 {
   execution_statet &ex_state = get_cur_state();
 
-  crypto_hash hash;
-  hash = ex_state.generate_hash();
-  hit_hashes.insert(hash);
+  hit_hashes.insert(ex_state.generate_hash());
 }
 
 void reachability_treet::create_next_state()
@@ -224,6 +221,7 @@ reachability_treet::decide_ileave_direction(execution_statet &ex_state)
   }
   //end - H.Savino
 
+  bool skipped_subtree = false;
   for(; tid < ex_state.threads_state.size(); tid++)
   {
     /* For all threads: */
@@ -233,6 +231,13 @@ reachability_treet::decide_ileave_direction(execution_statet &ex_state)
     if(!ex_state.dfs_explore_thread(tid))
       continue;
 
+    // Another --parallel-interleavings worker explores this subtree
+    if(!claim_subtree(tid))
+    {
+      skipped_subtree = true;
+      continue;
+    }
+
 #if 0
     //apply static partial-order reduction
     if (por && !ex_state.is_thread_mpor_schedulable(tid))
@@ -248,9 +253,120 @@ reachability_treet::decide_ileave_direction(execution_statet &ex_state)
     std::cerr << std::endl;
   }
 
+  // If every subtree from here belongs to other workers, the trace ending here
+  // is only a prefix of the interleavings they explore.
+  if(skipped_subtree && tid == ex_state.threads_state.size())
+    claim_skipped_all = true;
+
   return tid;
 }
 
+reachability_treet::subtree_claimst::subtree_claimst()
+  : cancel(false), winner(-1), interleavings(0), failed(0)
+{
+  for(unsigned int i = 0; i < num_slots; i++)
+  {
+    keys[i] = 0;
+    owners[i] = 0;
+  }
+}
+
+bool reachability_treet::subtree_claimst::claim(
+  uint64_t key,
+  unsigned int worker)
+{
+  assert(key != 0);
+
+  // Open addressing with linear probing; slots are never released, so a key
+  // always stays in the slot where it was first inserted.
+  unsigned int slot = (key * 0x9E3779B97F4A7C15ULL) >> 48;
+  for(unsigned int i = 0; i < num_slots; i++, slot = (slot + 1) % num_slots)
+  {
+    uint64_t expected = 0;
+    if(
+      !keys[slot].compare_exchange_strong(expected, key) && expected != key)
+      continue;
+
+    unsigned int owner = 0;
+    owners[slot].compare_exchange_strong(owner, worker + 1);
+    return owners[slot] == worker + 1;
+  }
+
+  // Table full: explore the subtree anyway. This duplicates work between
+  // workers, but never loses interleavings.
+  return true;
+}
+
+void reachability_treet::set_subtree_claims(
+  subtree_claimst *claims,
+  unsigned int worker,
+  unsigned int depth)
+{
+  subtree_claims = claims;
+  claim_worker = worker;
+  claim_depth = depth;
+}
+
+bool reachability_treet::get_path_key(unsigned int last, uint64_t &key) const
+{
+  // Each element of the path is stored in one non-zero byte, so that keys of
+  // different paths never collide.
+  key = 0;
+  unsigned int len = 0;
+
+  auto it = execution_states.begin();
+  for(++it; it != std::next(cur_state_it); ++it, ++len)
+  {
+    unsigned int tid = (*it)->get_active_state_number();
+    if(len == 8 || tid >= 0xFE)
+      return false;
+
+    key = (key << 8) | (tid + 1);
+  }
+
+  if(len == 8 || last > 0xFF)
+    return false;
+
+  key = (key << 8) | last;
+  return true;
+}
+
+bool reachability_treet::claim_subtree(unsigned int tid)
+{
+  if(subtree_claims == nullptr)
+    return true;
+
+  if(std::distance(execution_states.begin(), cur_state_it) + 1 != claim_depth)
+    return true;
+
+  uint64_t key;
+  if(tid >= 0xFE || !get_path_key(tid + 1, key))
+    return true;
+
+  return subtree_claims->claim(key, claim_worker);
+}
+
+bool reachability_treet::owns_current_interleaving()
+{
+  if(subtree_claims == nullptr)
+    return true;
+
+  if(claim_skipped_all)
+    return false;
+
+  // Anything deeper than the split depth went through a claimed subtree
+  if(std::distance(execution_states.begin(), cur_state_it) + 1 > claim_depth)
+    return true;
+
+  // Interleavings ending early are claimed as a whole; 0xFF marks the end of
+  // the path, distinguishing them from subtrees.
+  uint64_t key;
+  if(!get_path_key(0xFF, key))
+    return true;
+
+  return subtree_claims->claim(key, claim_worker);
+}
+
 bool reachability_treet::is_has_complete_formula()
 {
   return has_complete_formula;
@@ -698,6 +814,8 @@ reachability_treet::get_next_formula()
 {
   assert(execution_states.size() > 0 && "Must setup RT before exploring");
 
+  claim_skipped_all = false;
+
   while(!is_has_complete_formula())
   {
     while((!get_cur_state().has_cswitch_point_occured() ||
@@ -9,6 +9,7 @@ Author: Lucas Cordeiro, lcc08r@ecs.soton.ac.uk
 #ifndef REACHABILITY_TREE_H_
 #define REACHABILITY_TREE_H_
 
+#include <atomic>
 #include <deque>
 #include <goto-programs/goto_program.h>
 #include <goto-symex/execution_state.h>
@@ -18,7 +19,7 @@ Author: Lucas Cordeiro, lcc08r@ecs.soton.ac.uk
 #include <iostream>
 #include <unordered_map>
 #include <unordered_set>
-#include <util/crypto_hash.h>
+#include <util/state_hash.h>
 #include <util/message.h>
 #include <util/options.h>
 
@@ -243,6 +244,64 @@ public:
    */
   std::shared_ptr<goto_symext::symex_resultt> generate_schedule_formula();
 
+  /**
+   *  Table of interleaving subtrees claimed by --parallel-interleavings
+   *  workers.
+   *  Lives in memory shared between the forked worker processes. Every worker
+   *  walks the reachability tree down to the split depth; there, each
+   *  subtree below a context switch is identified by the sequence of thread
+   *  IDs leading to it, and explored only by the first worker to claim it.
+   *  Workers therefore pick up new subtrees as soon as they finish their
+   *  previous ones, balancing the load dynamically.
+   */
+  class subtree_claimst
+  {
+  public:
+    subtree_claimst();
+
+    /**
+     *  Claim a subtree for a worker.
+     *  @param key Non-zero identifier of the subtree
+     *  @param worker Worker number trying to claim the subtree
+     *  @return True if the subtree belongs to worker
+     */
+    bool claim(uint64_t key, unsigned int worker);
+
+    static const unsigned int num_slots = 1 << 16;
+
+    /** Set when a worker found a violation and the others should stop */
+    std::atomic<bool> cancel;
+    /** Worker that reports its counterexample; -1 if none yet */
+    std::atomic<int> winner;
+    /** Number of interleavings explored by all workers */
+    std::atomic<uint64_t> interleavings;
+    /** Number of failed interleavings found by all workers */
+    std::atomic<uint64_t> failed;
+
+  protected:
+    std::atomic<uint64_t> keys[num_slots];
+    std::atomic<unsigned int> owners[num_slots];
+  };
+
+  /**
+   *  Only explore subtrees claimed by this worker.
+   *  @param claims Shared table of subtree claims
+   *  @param worker Number of this worker
+   *  @param depth Context switch depth at which subtrees are claimed
+   */
+  void set_subtree_claims(
+    subtree_claimst *claims,
+    unsigned int worker,
+    unsigned int depth);
+
+  /**
+   *  Determine if the current interleaving belongs to this worker.
+   *  Interleavings that end before reaching the split depth are not part of
+   *  any claimed subtree, and are claimed individually here.
+   *  @return True if this worker should check the current interleaving
+   */
+  bool owns_current_interleaving();
+
   /**
    *  Reset ex_state stack to unexplored state.
    *  This is just a wrapper around reset_to_unexplored_state
@@ -367,7 +426,7 @@ protected:
   /** Whether partial-order-reduction is enabled */
   bool por;
   /** Set of state hashes we've discovered */
-  std::set<crypto_hash> hit_hashes;
+  state_hash_sett hit_hashes;
   /** Message handler reference. */
   message_handlert &message_handler;
   /** Flag as to whether we're picking interleaving directions explicitly.
@@ -377,6 +436,30 @@ protected:
   bool round_robin;
   /** Are we using the --schedule scheduling method? */
   bool schedule;
+  /** Subtree claims shared with other --parallel-interleavings workers, or
+   *  nullptr when exploring the whole tree */
+  subtree_claimst *subtree_claims;
+  /** Number of this worker in subtree_claims */
+  unsigned int claim_worker;
+  /** Context switch depth at which subtrees are claimed */
+  unsigned int claim_depth;
+  /** Current trace stopped because all its subtrees belong to other workers */
+  bool claim_skipped_all;
+
+  /**
+   *  Encode the path of thread IDs leading to the current state.
+   *  @param last Final element of the path
+   *  @param key Output key; each thread ID takes one byte
+   *  @return False if the path does not fit in a key
+   */
+  bool get_path_key(unsigned int last, uint64_t &key) const;
+
+  /**
+   *  Decide whether the subtree reached by switching to tid is ours.
+   *  @param tid Thread ID about to be switched to
+   *  @return True if the subtree should be explored by this worker
+   */
+  bool claim_subtree(unsigned int tid);
 
   /* Map to store the expression and thread ID,
    * which that expression belongs to. */
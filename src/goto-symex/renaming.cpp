@@ -296,7 +296,9 @@ void renaming::level2t::make_assignment(
   assert(
     to_symbol2t(lhs_symbol).rlevel == symbol2t::level1 ||
     to_symbol2t(lhs_symbol).rlevel == symbol2t::level1_global);
-  valuet &entry = current_names[name_record(to_symbol2t(lhs_symbol))];
+  name_record rec(to_symbol2t(lhs_symbol));
+  log_write(rec);
+  valuet &entry = current_names[rec];
 
   // This'll update entry beneath our feet; could reengineer it in the future.
   rename(lhs_symbol, entry.count + 1);
@@ -314,6 +316,34 @@ void renaming::level2t::make_assignment(
   entry.constant = const_value;
 }
 
+void renaming::level2t::log_write(const name_record &rec)
+{
+  if(!write_log)
+    write_log = std::make_shared<std::vector<name_record>>();
+  else if(write_log->size() != write_log_len)
+    // Another clone appended after our end of the log
+    write_log = std::make_shared<std::vector<name_record>>(
+      write_log->begin(), write_log->begin() + write_log_len);
+
+  write_log->push_back(rec);
+  write_log_len++;
+}
+
+void renaming::level2t::get_written_since(
+  size_t mark,
+  std::set<name_record> &vars) const
+{
+  if(mark > write_log_len)
+  {
+    // Not a mark from this level2t's history; be conservative
+    get_variables(vars);
+    return;
+  }
+
+  for(size_t i = mark; i < write_log_len; i++)
+    vars.insert((*write_log)[i]);
+}
+
 void renaming::level2t::rename_to_record(expr2tc &expr, const name_record &rec)
 {
   assert(expr->expr_id == expr2t::symbol_id);
@@ -3,11 +3,11 @@
 
 #include <set>
 #include <boost/functional/hash.hpp>
-#include <util/crypto_hash.h>
 #include <util/expr_util.h>
 #include <util/guard.h>
 #include <util/i2string.h>
 #include <util/irep2_expr.h>
+#include <util/persistent_map.h>
 #include <util/std_expr.h>
 
 namespace renaming
@@ -264,6 +264,18 @@ public:
     }
   }
 
+  /** Position in the log of assignments, to be passed to get_written_since
+   *  later on. */
+  size_t get_write_mark() const
+  {
+    return write_log_len;
+  }
+
+  /** Collect the variables assigned to since get_write_mark returned mark.
+   *  phi_function uses this so that merging only looks at variables written
+   *  on either branch, rather than all live ones. */
+  void get_written_since(size_t mark, std::set<name_record> &vars) const;
+
   unsigned current_number(const expr2tc &sym) const;
   unsigned current_number(const name_record &rec) const;
 
@@ -284,11 +296,18 @@ public:
 
   friend void build_goto_symex_classes();
   // Repeat of the above ignored friend directive.
-  typedef std::unordered_map<name_record, valuet, name_rec_hash> current_namest;
+  // Persistent, so that cloning a level2t for a goto_statet is O(1)
+  typedef persistent_mapt<name_record, valuet, name_rec_hash> current_namest;
 
   current_namest current_names;
-  typedef std::map<const expr2tc, crypto_hash> current_state_hashest;
-  current_state_hashest current_hashes;
+
+protected:
+  void log_write(const name_record &rec);
+
+  // The log is shared between clones; each clone only looks at its first
+  // write_log_len entries, and copies that prefix when they diverge.
+  std::shared_ptr<std::vector<name_record>> write_log;
+  size_t write_log_len = 0;
 };
 
 } // namespace renaming
@@ -6,38 +6,46 @@ Author: Daniel Kroening, kroening@kroening.com
 
 \*******************************************************************/
 
+#include <algorithm>
 #include <goto-symex/slice.h>
+#include <unordered_map>
 
-symex_slicet::symex_slicet(bool assume)
-  : ignored(0),
-    slice_assumes(assume),
-    add_to_deps([this](const symbol2t &s) -> bool {
-      return depends.insert(s.get_symbol_name()).second;
-    })
+symex_slicet::symex_slicet(bool assume) : ignored(0), slice_assumes(assume)
 {
 }
 
-bool symex_slicet::get_symbols(
-  const expr2tc &expr,
-  std::function<bool(const symbol2t &)> fn)
+void symex_slicet::add_to_deps(const expr2tc &expr)
 {
-  bool res = false;
-  expr->foreach_operand([this, &fn, &res](const expr2tc &e) {
+  if(!added.insert(expr.get()).second)
+    return;
+
+  expr->foreach_operand([this](const expr2tc &e) {
     if(!is_nil_expr(e))
-      res = get_symbols(e, fn) || res;
-    return res;
+      add_to_deps(e);
   });
 
-  if(!is_symbol2t(expr))
-    return res;
+  if(is_symbol2t(expr))
+    depends.insert(symbol_keyt(to_symbol2t(expr)));
+}
+
+bool symex_slicet::in_deps(const expr2tc &expr) const
+{
+  if(is_symbol2t(expr))
+    return depends.count(symbol_keyt(to_symbol2t(expr))) != 0;
+
+  bool res = false;
+  expr->foreach_operand([this, &res](const expr2tc &e) {
+    if(!res && !is_nil_expr(e))
+      res = in_deps(e);
+  });
 
-  const symbol2t &tmp = to_symbol2t(expr);
-  return fn(tmp) || res;
+  return res;
 }
 
 void symex_slicet::slice(std::shared_ptr<symex_target_equationt> &eq)
 {
   depends.clear();
+  added.clear();
 
   for(symex_target_equationt::SSA_stepst::reverse_iterator it =
         eq->SSA_steps.rbegin();
@@ -51,8 +59,8 @@ void symex_slicet::slice(symex_target_equationt::SSA_stept &SSA_step)
   switch(SSA_step.type)
   {
   case goto_trace_stept::ASSERT:
-    get_symbols(SSA_step.guard, add_to_deps);
-    get_symbols(SSA_step.cond, add_to_deps);
+    add_to_deps(SSA_step.guard);
+    add_to_deps(SSA_step.cond);
     break;
 
   case goto_trace_stept::ASSUME:
@@ -60,8 +68,8 @@ void symex_slicet::slice(symex_target_equationt::SSA_stept &SSA_step)
       slice_assume(SSA_step);
     else
     {
-      get_symbols(SSA_step.guard, add_to_deps);
-      get_symbols(SSA_step.cond, add_to_deps);
+      add_to_deps(SSA_step.guard);
+      add_to_deps(SSA_step.cond);
     }
     break;
 
@@ -83,11 +91,7 @@ void symex_slicet::slice(symex_target_equationt::SSA_stept &SSA_step)
 
 void symex_slicet::slice_assume(symex_target_equationt::SSA_stept &SSA_step)
 {
-  auto check_in_deps = [this](const symbol2t &s) -> bool {
-    return depends.find(s.get_symbol_name()) != depends.end();
-  };
-
-  if(!get_symbols(SSA_step.cond, check_in_deps))
+  if(!in_deps(SSA_step.cond))
   {
     // we don't really need it
     SSA_step.ignore = true;
@@ -96,8 +100,8 @@ void symex_slicet::slice_assume(symex_target_equationt::SSA_stept &SSA_step)
   else
   {
     // If we need it, add the symbols to dependency
-    get_symbols(SSA_step.guard, add_to_deps);
-    get_symbols(SSA_step.cond, add_to_deps);
+    add_to_deps(SSA_step.guard);
+    add_to_deps(SSA_step.cond);
   }
 }
 
@@ -105,11 +109,7 @@ void symex_slicet::slice_assignment(symex_target_equationt::SSA_stept &SSA_step)
 {
   assert(is_symbol2t(SSA_step.lhs));
 
-  auto check_in_deps = [this](const symbol2t &s) -> bool {
-    return depends.find(s.get_symbol_name()) != depends.end();
-  };
-
-  if(!get_symbols(SSA_step.lhs, check_in_deps))
+  if(!in_deps(SSA_step.lhs))
   {
     // we don't really need it
     SSA_step.ignore = true;
@@ -117,12 +117,12 @@ void symex_slicet::slice_assignment(symex_target_equationt::SSA_stept &SSA_step)
   }
   else
   {
-    get_symbols(SSA_step.guard, add_to_deps);
-    get_symbols(SSA_step.rhs, add_to_deps);
+    add_to_deps(SSA_step.guard);
+    add_to_deps(SSA_step.rhs);
 
     // Remove this symbol as we won't be seeing any references to it further
     // into the history.
-    depends.erase(to_symbol2t(SSA_step.lhs).get_symbol_name());
+    depends.erase(symbol_keyt(to_symbol2t(SSA_step.lhs)));
   }
 }
 
@@ -130,11 +130,7 @@ void symex_slicet::slice_renumber(symex_target_equationt::SSA_stept &SSA_step)
 {
   assert(is_symbol2t(SSA_step.lhs));
 
-  auto check_in_deps = [this](const symbol2t &s) -> bool {
-    return depends.find(s.get_symbol_name()) != depends.end();
-  };
-
-  if(!get_symbols(SSA_step.lhs, check_in_deps))
+  if(!in_deps(SSA_step.lhs))
   {
     // we don't really need it
     SSA_step.ignore = true;
@@ -144,6 +140,132 @@ void symex_slicet::slice_renumber(symex_target_equationt::SSA_stept &SSA_step)
   // Don't collect the symbol; this insn has no effect on dependencies.
 }
 
+static void get_symbols(
+  const expr2tc &expr,
+  std::unordered_set<const expr2t *> &seen,
+  std::vector<symbol_keyt> &symbols)
+{
+  if(!seen.insert(expr.get()).second)
+    return;
+
+  expr->foreach_operand([&seen, &symbols](const expr2tc &e) {
+    if(!is_nil_expr(e))
+      get_symbols(e, seen, symbols);
+  });
+
+  if(is_symbol2t(expr))
+    symbols.emplace_back(to_symbol2t(expr));
+}
+
+claim_slicet::claim_slicet(symex_target_equationt &eq, bool assume)
+  : slice_assumes(assume)
+{
+  for(auto it = eq.SSA_steps.begin(); it != eq.SSA_steps.end(); ++it)
+  {
+    if(it->is_assert() && !it->ignore)
+      claims.push_back(steps.size());
+
+    steps.push_back(it);
+    was_ignored.push_back(it->ignore);
+  }
+
+  reads.resize(steps.size());
+  unsigned int num_nodes = steps.size();
+
+  std::unordered_map<symbol_keyt, unsigned int, symbol_key_hash> defs;
+  std::unordered_set<const expr2t *> seen;
+  std::vector<symbol_keyt> symbols;
+  for(unsigned int i = 0; i < steps.size(); i++)
+  {
+    const symex_target_equationt::SSA_stept &step = *steps[i];
+    if(step.ignore)
+      continue;
+
+    // As in symex_slicet, renumbering steps read nothing
+    seen.clear();
+    symbols.clear();
+    if(step.is_assert() || step.is_assume())
+    {
+      get_symbols(step.guard, seen, symbols);
+      get_symbols(step.cond, seen, symbols);
+    }
+    else if(step.is_assignment())
+    {
+      get_symbols(step.guard, seen, symbols);
+      get_symbols(step.rhs, seen, symbols);
+    }
+
+    for(auto const &sym : symbols)
+    {
+      // SSA symbols are defined before they are used; any symbol we don't
+      // know of yet is free
+      auto res = defs.emplace(sym, num_nodes);
+      if(res.second)
+        num_nodes++;
+      reads[i].push_back(res.first->second);
+    }
+
+    if(step.is_assignment() || step.is_renumber())
+      defs[symbol_keyt(to_symbol2t(step.lhs))] = i;
+  }
+
+  in_cone.resize(num_nodes);
+}
+
+BigInt claim_slicet::slice(const std::vector<unsigned int> &claims)
+{
+  std::fill(in_cone.begin(), in_cone.end(), false);
+
+  unsigned int last = 0;
+  for(unsigned int claim : claims)
+  {
+    in_cone[claim] = true;
+    last = std::max(last, claim);
+  }
+
+  BigInt ignored = 0;
+  for(unsigned int i = steps.size(); i-- > 0;)
+  {
+    symex_target_equationt::SSA_stept &step = *steps[i];
+    step.ignore = was_ignored[i];
+    if(step.ignore)
+      continue;
+
+    // Nothing after the last claim can affect it
+    bool keep = false;
+    if(i > last)
+      keep = false;
+    else if(step.is_assume() && slice_assumes)
+    {
+      // Keep the assumptions on what the cone reads, as symex_slicet does
+      for(unsigned int node : reads[i])
+        keep = keep || in_cone[node];
+    }
+    else if(step.is_assume() || step.is_output())
+      keep = true;
+    else
+      keep = in_cone[i];
+
+    if(!keep)
+    {
+      step.ignore = true;
+      ++ignored;
+      continue;
+    }
+
+    for(unsigned int node : reads[i])
+      in_cone[node] = true;
+  }
+
+  return ignored;
+}
+
+void claim_slicet::restore()
+{
+  for(unsigned int i = 0; i < steps.size(); i++)
+    steps[i]->ignore = was_ignored[i];
+}
+
 BigInt slice(std::shared_ptr<symex_target_equationt> &eq, bool slice_assumes)
 {
   symex_slicet symex_slice(slice_assumes);
@@ -12,6 +12,8 @@ Author: Daniel Kroening, kroening@kroening.com
 #include <goto-symex/renaming.h>
 #include <goto-symex/symex_target_equation.h>
 #include <unordered_set>
+#include <util/irep2_utils.h>
+#include <vector>
 
 BigInt slice(std::shared_ptr<symex_target_equationt> &eq, bool slice_assume);
 BigInt simple_slice(std::shared_ptr<symex_target_equationt> &eq);
@@ -22,16 +24,21 @@ public:
   symex_slicet(bool assume);
   void slice(std::shared_ptr<symex_target_equationt> &eq);
 
-  typedef std::unordered_set<std::string> symbol_sett;
+  typedef std::unordered_set<symbol_keyt, symbol_key_hash> symbol_sett;
   symbol_sett depends;
   BigInt ignored;
 
 protected:
   bool slice_assumes;
-  std::function<bool(const symbol2t &)> add_to_deps;
 
-  bool
-  get_symbols(const expr2tc &expr, std::function<bool(const symbol2t &)> fn);
+  /** Expression nodes whose symbols have already been added to depends.
+   *  SSA symbols are never used before their definition, so on the backwards
+   *  walk these never need visiting again: guards and subterms shared
+   *  between steps are only walked once. */
+  std::unordered_set<const expr2t *> added;
+
+  void add_to_deps(const expr2tc &expr);
+  bool in_deps(const expr2tc &expr) const;
 
   void slice(symex_target_equationt::SSA_stept &SSA_step);
   void slice_assume(symex_target_equationt::SSA_stept &SSA_step);
@@ -39,4 +46,44 @@ protected:
   void slice_renumber(symex_target_equationt::SSA_stept &SSA_step);
 };
 
+/** Slices the equation separately for single claims.
+ *  The dependencies between the SSA steps are worked out once, on
+ *  construction; each call to slice() then only walks the steps up to the
+ *  claims it is given, and leaves nothing but their cone of influence for the
+ *  solver to see. */
+class claim_slicet
+{
+public:
+  claim_slicet(symex_target_equationt &eq, bool assume);
+
+  /** Ignore every step outside the cone of influence of the given claims,
+   *  including all other claims.
+   *  @param claims Indexes of the claims' steps, as in claim_slicet::claims
+   *  @return Number of steps ignored on top of those ignored on construction */
+  BigInt slice(const std::vector<unsigned int> &claims);
+
+  /** Put back the ignore flags the steps had on construction */
+  void restore();
+
+  symex_target_equationt::SSA_stept &get_step(unsigned int idx)
+  {
+    return *steps[idx];
+  }
+
+  /** Indexes of the steps of all claims that aren't already ignored */
+  std::vector<unsigned int> claims;
+
+protected:
+  bool slice_assumes;
+
+  std::vector<symex_target_equationt::SSA_stepst::iterator> steps;
+  std::vector<bool> was_ignored;
+
+  /** For each step, the nodes of the steps defining the symbols it reads.
+   *  Symbols without a definition get a node of their own, numbered after
+   *  the steps, so that assumptions on them can still be sliced. */
+  std::vector<std::vector<unsigned int>> reads;
+  std::vector<bool> in_cone;
+};
+
 #endif
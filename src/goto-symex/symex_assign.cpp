@@ -7,6 +7,8 @@ Author: Daniel Kroening, kroening@kroening.com
 \*******************************************************************/
 
 #include <cassert>
+#include <climits>
+#include <cstdlib>
 #include <goto-symex/dynamic_allocation.h>
 #include <goto-symex/execution_state.h>
 #include <goto-symex/goto_symex.h>
@@ -51,7 +53,12 @@ goto_symext::goto_symext(
     k_induction(options.get_bool_option("k-induction")),
     base_case(options.get_bool_option("base-case")),
     forward_condition(options.get_bool_option("forward-condition")),
-    inductive_step(options.get_bool_option("inductive-step"))
+    inductive_step(options.get_bool_option("inductive-step")),
+    smt_symex_guard(options.get_bool_option("smt-symex-guard")),
+    guard_solver_budget(
+      options.get_option("smt-symex-guard-budget").empty()
+        ? ULONG_MAX
+        : atol(options.get_option("smt-symex-guard-budget").c_str()))
 {
   const std::string &set = options.get_option("unwindset");
   unsigned int length = set.length();
@@ -112,6 +119,9 @@ goto_symext &goto_symext::operator=(const goto_symext &sym)
   base_case = sym.base_case;
   forward_condition = sym.forward_condition;
   inductive_step = sym.inductive_step;
+  smt_symex_guard = sym.smt_symex_guard;
+  guard_solver_budget = sym.guard_solver_budget;
+  guard_definitions = sym.guard_definitions;
   first_loop = sym.first_loop;
 
   valid_ptr_arr_name = sym.valid_ptr_arr_name;
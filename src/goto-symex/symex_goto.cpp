@@ -7,6 +7,7 @@
 
 \*******************************************************************/
 
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 #include <goto-symex/goto_symex.h>
@@ -21,6 +22,343 @@
 #include <util/prefix.h>
 #include <util/std_expr.h>
 
+goto_symext::guard_statst goto_symext::guard_stats;
+
+namespace
+{
+/** What the literals of a path guard say about the expressions in a branch
+ *  guard: the truth of boolean atoms, and bounds on integer expressions
+ *  compared against constants. Guard symbols are looked through, up to a
+ *  small depth, using the expressions they were assigned. */
+class path_factst
+{
+public:
+  typedef std::unordered_map<expr2tc, expr2tc, irep2_hash> definitionst;
+
+  path_factst(const expr2tc &path_guard, const definitionst &_definitions)
+    : definitions(_definitions)
+  {
+    add(path_guard, false, 0);
+  }
+
+  tvt eval(const expr2tc &cond, unsigned int depth = 0) const;
+
+protected:
+  static const unsigned int max_depth = 4;
+
+  enum relt
+  {
+    LT,
+    LE,
+    GT,
+    GE,
+    EQ,
+    NE
+  };
+
+  class boundt
+  {
+  public:
+    boundt() : has_lo(false), has_hi(false)
+    {
+    }
+
+    bool has_lo, has_hi;
+    BigInt lo, hi;
+    std::vector<BigInt> excluded;
+  };
+
+  static bool get_relation(
+    const expr2tc &e,
+    bool negated,
+    expr2tc &x,
+    relt &rel,
+    BigInt &c);
+  void add(const expr2tc &e, bool negated, unsigned int depth);
+  tvt eval_relation(const expr2tc &x, relt rel, const BigInt &c) const;
+
+  const definitionst &definitions;
+  std::unordered_map<expr2tc, boundt, irep2_hash> bounds;
+  std::unordered_map<expr2tc, bool, irep2_hash> truths;
+};
+
+bool path_factst::get_relation(
+  const expr2tc &e,
+  bool negated,
+  expr2tc &x,
+  relt &rel,
+  BigInt &c)
+{
+  const expr2tc *side_1, *side_2;
+  if(is_lessthan2t(e))
+  {
+    rel = LT;
+    side_1 = &to_lessthan2t(e).side_1;
+    side_2 = &to_lessthan2t(e).side_2;
+  }
+  else if(is_lessthanequal2t(e))
+  {
+    rel = LE;
+    side_1 = &to_lessthanequal2t(e).side_1;
+    side_2 = &to_lessthanequal2t(e).side_2;
+  }
+  else if(is_greaterthan2t(e))
+  {
+    rel = GT;
+    side_1 = &to_greaterthan2t(e).side_1;
+    side_2 = &to_greaterthan2t(e).side_2;
+  }
+  else if(is_greaterthanequal2t(e))
+  {
+    rel = GE;
+    side_1 = &to_greaterthanequal2t(e).side_1;
+    side_2 = &to_greaterthanequal2t(e).side_2;
+  }
+  else if(is_equality2t(e))
+  {
+    rel = EQ;
+    side_1 = &to_equality2t(e).side_1;
+    side_2 = &to_equality2t(e).side_2;
+  }
+  else if(is_notequal2t(e))
+  {
+    rel = NE;
+    side_1 = &to_notequal2t(e).side_1;
+    side_2 = &to_notequal2t(e).side_2;
+  }
+  else
+    return false;
+
+  // Only integers: floating point comparisons don't negate like this
+  if(!is_signedbv_type(*side_1) && !is_unsignedbv_type(*side_1))
+    return false;
+
+  if(is_constant_int2t(*side_2) && !is_constant_int2t(*side_1))
+  {
+    x = *side_1;
+    c = to_constant_int2t(*side_2).value;
+  }
+  else if(is_constant_int2t(*side_1) && !is_constant_int2t(*side_2))
+  {
+    // c < x is x > c, and so on
+    x = *side_2;
+    c = to_constant_int2t(*side_1).value;
+    static const relt swapped[] = {GT, GE, LT, LE, EQ, NE};
+    rel = swapped[rel];
+  }
+  else
+    return false;
+
+  if(negated)
+  {
+    static const relt inverted[] = {GE, GT, LE, LT, NE, EQ};
+    rel = inverted[rel];
+  }
+
+  return true;
+}
+
+void path_factst::add(const expr2tc &e, bool negated, unsigned int depth)
+{
+  if(is_not2t(e))
+  {
+    add(to_not2t(e).value, !negated, depth);
+    return;
+  }
+
+  if(is_and2t(e) && !negated)
+  {
+    add(to_and2t(e).side_1, false, depth);
+    add(to_and2t(e).side_2, false, depth);
+    return;
+  }
+
+  if(is_or2t(e) && negated)
+  {
+    add(to_or2t(e).side_1, true, depth);
+    add(to_or2t(e).side_2, true, depth);
+    return;
+  }
+
+  if(is_constant_bool2t(e))
+    return;
+
+  expr2tc x;
+  relt rel;
+  BigInt c;
+  if(get_relation(e, negated, x, rel, c))
+  {
+    boundt &b = bounds[x];
+    if((rel == LE || rel == EQ) && (!b.has_hi || c < b.hi))
+    {
+      b.has_hi = true;
+      b.hi = c;
+    }
+    else if(rel == LT && (!b.has_hi || c - 1 < b.hi))
+    {
+      b.has_hi = true;
+      b.hi = c - 1;
+    }
+
+    if((rel == GE || rel == EQ) && (!b.has_lo || c > b.lo))
+    {
+      b.has_lo = true;
+      b.lo = c;
+    }
+    else if(rel == GT && (!b.has_lo || c + 1 > b.lo))
+    {
+      b.has_lo = true;
+      b.lo = c + 1;
+    }
+
+    if(rel == NE)
+      b.excluded.push_back(c);
+
+    return;
+  }
+
+  truths[e] = !negated;
+
+  if(depth < max_depth && is_symbol2t(e))
+  {
+    auto it = definitions.find(e);
+    if(it != definitions.end())
+      add(it->second, negated, depth + 1);
+  }
+}
+
+tvt path_factst::eval_relation(const expr2tc &x, relt rel, const BigInt &c)
+  const
+{
+  auto it = bounds.find(x);
+  if(it == bounds.end())
+    return tvt(tvt::TV_UNKNOWN);
+
+  const boundt &b = it->second;
+
+  // An empty range means the path itself is infeasible; that's for the
+  // solver to find out.
+  if(b.has_lo && b.has_hi && b.lo > b.hi)
+    return tvt(tvt::TV_UNKNOWN);
+
+  switch(rel)
+  {
+  case EQ:
+  case NE:
+  {
+    tvt eq(tvt::TV_UNKNOWN);
+    if((b.has_lo && c < b.lo) || (b.has_hi && c > b.hi))
+      eq = tvt(false);
+    else if(
+      std::find(b.excluded.begin(), b.excluded.end(), c) !=
+      b.excluded.end())
+      eq = tvt(false);
+    else if(b.has_lo && b.has_hi && b.lo == c && b.hi == c)
+      eq = tvt(true);
+    return rel == EQ ? eq : !eq;
+  }
+  case LT:
+    if(b.has_hi && b.hi < c)
+      return tvt(true);
+    if(b.has_lo && b.lo >= c)
+      return tvt(false);
+    break;
+  case LE:
+    if(b.has_hi && b.hi <= c)
+      return tvt(true);
+    if(b.has_lo && b.lo > c)
+      return tvt(false);
+    break;
+  case GT:
+    return !eval_relation(x, LE, c);
+  case GE:
+    return !eval_relation(x, LT, c);
+  }
+
+  return tvt(tvt::TV_UNKNOWN);
+}
+
+tvt path_factst::eval(const expr2tc &cond, unsigned int depth) const
+{
+  if(is_constant_bool2t(cond))
+    return tvt(to_constant_bool2t(cond).value);
+
+  if(is_not2t(cond))
+    return !eval(to_not2t(cond).value, depth);
+
+  if(is_and2t(cond))
+    return eval(to_and2t(cond).side_1, depth) &&
+           eval(to_and2t(cond).side_2, depth);
+
+  if(is_or2t(cond))
+    return eval(to_or2t(cond).side_1, depth) ||
+           eval(to_or2t(cond).side_2, depth);
+
+  expr2tc x;
+  relt rel;
+  BigInt c;
+  if(get_relation(cond, false, x, rel, c))
+    return eval_relation(x, rel, c);
+
+  auto it = truths.find(cond);
+  if(it != truths.end())
+    return tvt(it->second);
+
+  if(depth < max_depth && is_symbol2t(cond))
+  {
+    auto def = definitions.find(cond);
+    if(def != definitions.end())
+      return eval(def->second, depth + 1);
+  }
+
+  return tvt(tvt::TV_UNKNOWN);
+}
+} // namespace
+
+tvt goto_symext::decide_branch_guard(const expr2tc &new_guard)
+{
+  guard_stats.checked++;
+
+  // Cheap check first: what the path guard already says about new_guard
+  path_factst facts(cur_state->guard.as_expr(), guard_definitions);
+  tvt res = facts.eval(new_guard);
+  if(res.is_known())
+  {
+    guard_stats.by_path++;
+    return res;
+  }
+
+  if(guard_stats.solver_queries >= guard_solver_budget)
+  {
+    guard_stats.over_budget++;
+    return res;
+  }
+
+  auto rte = std::dynamic_pointer_cast<runtime_encoded_equationt>(target);
+
+  guard_stats.solver_queries++;
+  fine_timet solver_start = current_time();
+
+  equality2tc question(gen_true_expr(), new_guard);
+  try
+  {
+    res = rte->ask_solver_question(question);
+  }
+  catch(runtime_encoded_equationt::dual_unsat_exception &e)
+  {
+    // Assumptions mean that the guard is never satisfiable as true or false,
+    // basically means we've assume'd away the possibility of hitting this
+    // point.
+    res = tvt(false);
+  }
+
+  guard_stats.solver_time += current_time() - solver_start;
+  if(res.is_known())
+    guard_stats.by_solver++;
+
+  return res;
+}
+
 void goto_symext::symex_goto(const expr2tc &old_guard)
 {
   const goto_programt::instructiont &instruction = *cur_state->source.pc;
@@ -32,27 +370,14 @@ void goto_symext::symex_goto(const expr2tc &old_guard)
   bool new_guard_false = (is_false(new_guard) || cur_state->guard.is_false());
   bool new_guard_true = is_true(new_guard);
 
-  if(!new_guard_false && options.get_bool_option("smt-symex-guard"))
+  if(!new_guard_false && !new_guard_true && smt_symex_guard)
   {
-    auto rte = std::dynamic_pointer_cast<runtime_encoded_equationt>(target);
-
-    equality2tc question(gen_true_expr(), new_guard);
-    try
-    {
-      tvt res = rte->ask_solver_question(question);
+    tvt res = decide_branch_guard(new_guard);
 
-      if(res.is_false())
-        new_guard_false = true;
-      else if(res.is_true())
-        new_guard_true = true;
-    }
-    catch(runtime_encoded_equationt::dual_unsat_exception &e)
-    {
-      // Assumptions mean that the guard is never satisfiable as true or false,
-      // basically means we've assume'd away the possibility of hitting this
-      // point.
+    if(res.is_false())
       new_guard_false = true;
-    }
+    else if(res.is_true())
+      new_guard_true = true;
   }
 
   goto_programt::const_targett goto_target = instruction.targets.front();
@@ -184,6 +509,9 @@ void goto_symext::symex_goto(const expr2tc &old_guard)
 
       cur_state->assignment(guard_expr, new_rhs);
 
+      if(smt_symex_guard)
+        guard_definitions[guard_expr] = new_rhs;
+
       target->assignment(
         gen_true_expr(),
         guard_expr,
@@ -321,12 +649,10 @@ void goto_symext::phi_function(const statet::goto_statet &goto_state)
   if(goto_state.guard.is_false() && cur_state->guard.is_false())
     return;
 
-  // go over all variables to see what changed
+  // Only variables assigned to since goto_state was saved can differ; the
+  // goto_state itself is a snapshot, nothing was written on its side.
   std::set<renaming::level2t::name_record> variables;
-  cur_state->level2.get_variables(variables);
-
-  std::set<renaming::level2t::name_record> goto_variables;
-  goto_state.level2.get_variables(goto_variables);
+  cur_state->level2.get_written_since(goto_state.write_mark, variables);
 
   guardt tmp_guard;
   if(
@@ -341,6 +667,10 @@ void goto_symext::phi_function(const statet::goto_statet &goto_state)
 
   for(const auto &variable : variables)
   {
+    // Assigned to, then removed again
+    if(cur_state->level2.current_names.count(variable) == 0)
+      continue;
+
     if(
       goto_state.level2.current_number(variable) ==
       cur_state->level2.current_number(variable))
@@ -354,7 +684,7 @@ void goto_symext::phi_function(const statet::goto_statet &goto_state)
 
     // If the variable was deleted in this branch, don't create an assignment
     // for it
-    if(goto_variables.find(variable) == goto_variables.end())
+    if(goto_state.level2.current_names.count(variable) == 0)
       continue;
 
     // changed!
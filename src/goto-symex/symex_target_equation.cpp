@@ -6,6 +6,9 @@ Author: Daniel Kroening, kroening@kroening.com
 
 \*******************************************************************/
 
+#include <algorithm>
+#include <atomic>
+#include <boost/functional/hash.hpp>
 #include <cassert>
 #include <goto-symex/goto_symex.h>
 #include <goto-symex/goto_symex_state.h>
@@ -16,6 +19,61 @@ Author: Daniel Kroening, kroening@kroening.com
 #include <util/irep2.h>
 #include <util/migrate.h>
 #include <util/std_expr.h>
+#include <thread>
+
+size_t stack_treet::key_hasht::operator()(const keyt &key) const
+{
+  size_t seed = 0;
+  boost::hash_combine(seed, key.parent);
+  boost::hash_combine(seed, key.function);
+  boost::hash_combine(seed, key.location);
+  boost::hash_combine(seed, key.thread);
+  return seed;
+}
+
+stack_treet::keyt
+stack_treet::get_key(unsigned int parent, const stack_framet &frame)
+{
+  keyt key;
+  key.parent = parent;
+  key.function = frame.function.get_no();
+  key.location =
+    frame.src == nullptr ? UINT_MAX : frame.src->pc->location_number;
+  key.thread = frame.src == nullptr ? 0 : frame.src->thread_nr;
+  return key;
+}
+
+unsigned int stack_treet::intern(const std::vector<stack_framet> &trace)
+{
+  // Start from the outermost frame, the root side of the tree
+  unsigned int node = no_node;
+  for(auto it = trace.rbegin(); it != trace.rend(); ++it)
+  {
+    auto res = index.emplace(get_key(node, *it), nodes.size());
+    if(res.second)
+      nodes.push_back(nodet{*it, node});
+    node = res.first->second;
+  }
+
+  return node;
+}
+
+std::vector<stack_framet> stack_treet::get(unsigned int node) const
+{
+  std::vector<stack_framet> trace;
+  for(; node != no_node; node = nodes[node].parent)
+    trace.push_back(nodes[node].frame);
+
+  return trace;
+}
+
+void stack_treet::truncate(size_t size)
+{
+  // Nodes only point to older ones, so the remaining ones stay complete
+  for(size_t i = size; i < nodes.size(); i++)
+    index.erase(get_key(nodes[i].parent, nodes[i].frame));
+  nodes.erase(nodes.begin() + size, nodes.end());
+}
 
 void symex_target_equationt::assignment(
   const expr2tc &guard,
@@ -38,11 +96,15 @@ void symex_target_equationt::assignment(
   SSA_step.original_lhs = original_lhs;
   SSA_step.original_rhs = original_rhs;
   SSA_step.rhs = rhs;
+  expr_pool.intern(SSA_step.guard);
+  expr_pool.intern(SSA_step.lhs);
+  expr_pool.intern(SSA_step.rhs);
   SSA_step.hidden = hidden;
-  SSA_step.cond = equality2tc(lhs, rhs);
+  SSA_step.cond = equality2tc(SSA_step.lhs, SSA_step.rhs);
+  expr_pool.intern(SSA_step.cond);
   SSA_step.type = goto_trace_stept::ASSIGNMENT;
   SSA_step.source = source;
-  SSA_step.stack_trace = stack_trace;
+  SSA_step.stack_node = stack_tree.intern(stack_trace);
   SSA_step.loop_number = loop_number;
 
   if(debug_print)
@@ -59,10 +121,16 @@ void symex_target_equationt::output(
   SSA_stept &SSA_step = SSA_steps.back();
 
   SSA_step.guard = guard;
+  expr_pool.intern(SSA_step.guard);
   SSA_step.type = goto_trace_stept::OUTPUT;
   SSA_step.source = source;
-  SSA_step.output_args = args;
-  SSA_step.format_string = fmt;
+  SSA_step.output_idx = outputs.size();
+  outputs.emplace_back();
+  SSA_outputt &out = outputs.back();
+  out.output_args = args;
+  for(auto &arg : out.output_args)
+    expr_pool.intern(arg);
+  out.format_string = fmt;
 
   if(debug_print)
     SSA_step.output(ns, std::cout);
@@ -79,6 +147,8 @@ void symex_target_equationt::assumption(
 
   SSA_step.guard = guard;
   SSA_step.cond = cond;
+  expr_pool.intern(SSA_step.guard);
+  expr_pool.intern(SSA_step.cond);
   SSA_step.type = goto_trace_stept::ASSUME;
   SSA_step.source = source;
   SSA_step.loop_number = loop_number;
@@ -100,10 +170,12 @@ void symex_target_equationt::assertion(
 
   SSA_step.guard = guard;
   SSA_step.cond = cond;
+  expr_pool.intern(SSA_step.guard);
+  expr_pool.intern(SSA_step.cond);
   SSA_step.type = goto_trace_stept::ASSERT;
   SSA_step.source = source;
   SSA_step.comment = msg;
-  SSA_step.stack_trace = stack_trace;
+  SSA_step.stack_node = stack_tree.intern(stack_trace);
   SSA_step.loop_number = loop_number;
 
   if(debug_print)
@@ -124,6 +196,9 @@ void symex_target_equationt::renumber(
   SSA_step.guard = guard;
   SSA_step.lhs = symbol;
   SSA_step.rhs = size;
+  expr_pool.intern(SSA_step.guard);
+  expr_pool.intern(SSA_step.lhs);
+  expr_pool.intern(SSA_step.rhs);
   SSA_step.type = goto_trace_stept::RENUMBER;
   SSA_step.source = source;
 
@@ -134,14 +209,157 @@ void symex_target_equationt::renumber(
 void symex_target_equationt::convert(smt_convt &smt_conv)
 {
   smt_convt::ast_vec assertions;
+  convert_claims(smt_conv, assertions);
+
+  if(!assertions.empty())
+    smt_conv.assert_ast(
+      smt_conv.make_n_ary(&smt_conv, &smt_convt::mk_or, assertions));
+}
+
+void symex_target_equationt::convert_claims(
+  smt_convt &smt_conv,
+  smt_convt::ast_vec &violations)
+{
   smt_astt assumpt_ast = smt_conv.convert_ast(gen_true_expr());
 
   for(auto &SSA_step : SSA_steps)
-    convert_internal_step(smt_conv, assumpt_ast, assertions, SSA_step);
+    convert_internal_step(smt_conv, assumpt_ast, violations, SSA_step);
+}
+
+fine_timet symex_target_equationt::hash_steps(unsigned int threads) const
+{
+  std::vector<const SSA_stept *> steps;
+  steps.reserve(SSA_steps.size());
+  for(auto const &step : SSA_steps)
+  {
+    if(!step.ignore)
+      steps.push_back(&step);
+  }
+
+  // Hand out the steps in chunks, so that threads finishing early can take
+  // over work from the others
+  const unsigned int chunk = 64;
+  std::atomic<size_t> next(0);
+  std::vector<fine_timet> busy(threads, 0);
+
+  auto hash_some_steps = [this, &steps, &next, &busy](unsigned int t) {
+    fine_timet start = current_time();
+
+    for(size_t i = next.fetch_add(chunk); i < steps.size();
+        i = next.fetch_add(chunk))
+    {
+      size_t end = std::min(i + chunk, steps.size());
+      for(; i < end; ++i)
+      {
+        const SSA_stept &step = *steps[i];
+        if(!is_nil_expr(step.guard))
+          step.guard.crc();
+        if(!is_nil_expr(step.cond))
+          step.cond.crc();
+        if(!step.is_output())
+          continue;
+        for(auto const &arg : get_output(step).output_args)
+        {
+          if(!is_nil_expr(arg))
+            arg.crc();
+        }
+      }
+    }
+
+    busy[t] = current_time() - start;
+  };
+
+  std::vector<std::thread> pool;
+  for(unsigned int t = 1; t < threads; ++t)
+    pool.emplace_back(hash_some_steps, t);
+
+  hash_some_steps(0);
+
+  for(auto &thread : pool)
+    thread.join();
+
+  fine_timet total = 0;
+  for(fine_timet t : busy)
+    total += t;
+
+  return total;
+}
+
+static bool same_step(
+  const symex_target_equationt::SSA_stept &a,
+  const std::vector<symex_target_equationt::SSA_outputt> &a_outputs,
+  const symex_target_equationt::SSA_stept &b,
+  const std::vector<symex_target_equationt::SSA_outputt> &b_outputs)
+{
+  if(
+    a.type != b.type || a.ignore != b.ignore || a.guard != b.guard ||
+    a.cond != b.cond || a.lhs != b.lhs || a.rhs != b.rhs)
+    return false;
+
+  return !a.is_output() || a_outputs[a.output_idx].output_args ==
+                             b_outputs[b.output_idx].output_args;
+}
+
+bool symex_target_equationt::convert_prefixed(
+  smt_convt &smt_conv,
+  encoded_prefixt &prefix)
+{
+  if(prefix.pushed)
+  {
+    smt_conv.pop_ctx();
+    prefix.pushed = false;
+  }
+
+  // Find how many leading steps this equation shares with the last one
+  unsigned int common = 0;
+  SSA_stepst::iterator it = SSA_steps.begin();
+  for(SSA_stepst::const_iterator last_it = prefix.steps.begin();
+      it != SSA_steps.end() && last_it != prefix.steps.end() &&
+      same_step(*it, outputs, *last_it, prefix.outputs);
+      ++it, ++last_it)
+  {
+    // Steps at the base context level were converted already; reuse the
+    // results, they are needed to build counterexamples
+    if(common < prefix.encoded)
+    {
+      it->guard_ast = last_it->guard_ast;
+      it->cond_ast = last_it->cond_ast;
+      if(it->is_output())
+        get_output(*it).converted_output_args =
+          prefix.outputs[last_it->output_idx].converted_output_args;
+    }
+
+    ++common;
+  }
+
+  if(common < prefix.encoded)
+    return false;
+
+  if(prefix.assumpt_ast == nullptr)
+    prefix.assumpt_ast = smt_conv.convert_ast(gen_true_expr());
+
+  // Steps shared with the last equation will likely be shared with the next
+  // one too: move them to the base context level
+  it = get_SSA_step(prefix.encoded);
+  for(; prefix.encoded < common; ++prefix.encoded, ++it)
+    convert_internal_step(
+      smt_conv, prefix.assumpt_ast, prefix.violations, *it);
+
+  smt_conv.push_ctx();
+  prefix.pushed = true;
+
+  smt_astt assumpt_ast = prefix.assumpt_ast;
+  smt_convt::ast_vec assertions = prefix.violations;
+  for(; it != SSA_steps.end(); ++it)
+    convert_internal_step(smt_conv, assumpt_ast, assertions, *it);
 
   if(!assertions.empty())
     smt_conv.assert_ast(
       smt_conv.make_n_ary(&smt_conv, &smt_convt::mk_or, assertions));
+
+  prefix.steps = SSA_steps;
+  prefix.outputs = outputs;
+  return true;
 }
 
 void symex_target_equationt::convert_internal_step(
@@ -158,6 +376,8 @@ void symex_target_equationt::convert_internal_step(
   {
     step.cond_ast = true_val;
     step.guard_ast = false_val;
+    if(release_encoded)
+      release_step(step);
     return;
   }
 
@@ -191,19 +411,20 @@ void symex_target_equationt::convert_internal_step(
   }
   else if(step.is_output())
   {
-    for(std::list<expr2tc>::const_iterator o_it = step.output_args.begin();
-        o_it != step.output_args.end();
+    SSA_outputt &out = get_output(step);
+    for(std::list<expr2tc>::const_iterator o_it = out.output_args.begin();
+        o_it != out.output_args.end();
         o_it++)
     {
       const expr2tc &tmp = *o_it;
       if(is_constant_expr(tmp) || is_constant_string2t(tmp))
-        step.converted_output_args.push_back(tmp);
+        out.converted_output_args.push_back(tmp);
       else
       {
         symbol2tc sym(tmp->type, "symex::output::" + i2string(output_count++));
         equality2tc eq(sym, tmp);
         smt_conv.set_to(eq, true);
-        step.converted_output_args.push_back(sym);
+        out.converted_output_args.push_back(sym);
       }
     }
   }
@@ -228,6 +449,31 @@ void symex_target_equationt::convert_internal_step(
     v.push_back(step.cond_ast);
     assumpt_ast = smt_conv.make_n_ary(&smt_conv, &smt_convt::mk_and, v);
   }
+
+  if(release_encoded)
+    release_step(step);
+}
+
+void symex_target_equationt::release_step(SSA_stept &step)
+{
+  // Once converted, a step is only looked at again to build a counterexample,
+  // which needs the ASTs and the original names and values of assignments.
+  step.guard = expr2tc();
+  step.cond = expr2tc();
+  step.lhs = expr2tc();
+
+  if(step.ignore)
+  {
+    // Never part of a counterexample
+    step.rhs = expr2tc();
+    step.original_lhs = expr2tc();
+    step.original_rhs = expr2tc();
+  }
+  else if(!is_nil_expr(step.original_rhs))
+    step.rhs = expr2tc();
+
+  if(step.is_output())
+    get_output(step).output_args.clear();
 }
 
 void symex_target_equationt::output(std::ostream &out) const
@@ -361,22 +607,23 @@ void symex_target_equationt::check_for_duplicate_assigns() const
 
 unsigned int symex_target_equationt::clear_assertions()
 {
-  unsigned int num_asserts = 0;
-
-  for(SSA_stepst::iterator it = SSA_steps.begin(); it != SSA_steps.end(); it++)
-  {
-    if(it->type == goto_trace_stept::ASSERT)
-    {
-      SSA_stepst::iterator it2 = it;
-      it--;
-      SSA_steps.erase(it2);
-      num_asserts++;
-    }
-  }
+  SSA_stepst::iterator it = std::remove_if(
+    SSA_steps.begin(), SSA_steps.end(), [](const SSA_stept &step) {
+      return step.type == goto_trace_stept::ASSERT;
+    });
 
+  unsigned int num_asserts = SSA_steps.end() - it;
+  SSA_steps.erase(it, SSA_steps.end());
   return num_asserts;
 }
 
+void symex_target_equationt::truncate(const markt &mark)
+{
+  SSA_steps.erase(SSA_steps.begin() + mark.steps, SSA_steps.end());
+  stack_tree.truncate(mark.stack_nodes);
+  outputs.resize(mark.outputs);
+}
+
 runtime_encoded_equationt::runtime_encoded_equationt(
   const namespacet &_ns,
   smt_convt &_conv)
@@ -384,42 +631,18 @@ runtime_encoded_equationt::runtime_encoded_equationt(
 {
   assert_vec_list.emplace_back();
   assumpt_chain.push_back(conv.convert_ast(gen_true_expr()));
-  cvt_progress = SSA_steps.end();
+  cvt_progress = 0;
 }
 
 void runtime_encoded_equationt::flush_latest_instructions()
 {
-  if(SSA_steps.size() == 0)
-    return;
-
-  SSA_stepst::iterator run_it = cvt_progress;
-  // Scenarios:
-  // * We're at the start of running, in which case cvt_progress == end
-  // * We're in the middle, but nothing is left to push, so run_it + 1 == end
-  // * We're in the middle, and there's more to convert.
-  if(run_it == SSA_steps.end())
-  {
-    run_it = SSA_steps.begin();
-  }
-  else
-  {
-    run_it++;
-    if(run_it == SSA_steps.end())
-    {
-      // There is in fact, nothing to do
-      return;
-    }
-
-    // Just roll on
-  }
-
-  // Now iterate from the start insn to convert, to the end of the list.
-  for(; run_it != SSA_steps.end(); ++run_it)
+  // Convert whatever was recorded since the last flush
+  for(; cvt_progress < SSA_steps.size(); ++cvt_progress)
     convert_internal_step(
-      conv, assumpt_chain.back(), assert_vec_list.back(), *run_it);
-
-  run_it--;
-  cvt_progress = run_it;
+      conv,
+      assumpt_chain.back(),
+      assert_vec_list.back(),
+      SSA_steps[cvt_progress]);
 }
 
 void runtime_encoded_equationt::push_ctx()
@@ -429,19 +652,22 @@ void runtime_encoded_equationt::push_ctx()
   // And push everything back.
   assumpt_chain.push_back(assumpt_chain.back());
   assert_vec_list.push_back(assert_vec_list.back());
-  scoped_end_points.push_back(cvt_progress);
+  scoped_end_points.push_back(get_mark());
+  answered_marks.push_back(answered_log.size());
   conv.push_ctx();
 }
 
 void runtime_encoded_equationt::pop_ctx()
 {
-  SSA_stepst::iterator it = scoped_end_points.back();
-  cvt_progress = it;
+  const markt &mark = scoped_end_points.back();
+  truncate(mark);
+  cvt_progress = mark.steps;
 
-  if(SSA_steps.size() != 0)
-    ++it;
-
-  SSA_steps.erase(it, SSA_steps.end());
+  // Forget the answers that relied on the popped constraints
+  for(size_t i = answered_marks.back(); i < answered_log.size(); i++)
+    answered.erase(answered_log[i]);
+  answered_log.resize(answered_marks.back());
+  answered_marks.pop_back();
 
   conv.pop_ctx();
   scoped_end_points.pop_back();
@@ -475,43 +701,36 @@ std::shared_ptr<symex_targett> runtime_encoded_equationt::clone() const
     "cloned when it contains data");
   auto nthis = std::shared_ptr<runtime_encoded_equationt>(
     new runtime_encoded_equationt(*this));
-  nthis->cvt_progress = nthis->SSA_steps.end();
+  nthis->cvt_progress = 0;
   return nthis;
 }
 
 tvt runtime_encoded_equationt::ask_solver_question(const expr2tc &question)
 {
-  tvt final_res;
+  auto it = answered.find(question);
+  if(it != answered.end())
+    return it->second;
 
-  // So - we have a formula, we want to work out whether it's true, false, or
-  // unknown. Before doing anything, first push a context, as we'll need to
-  // wipe some state afterwards.
-  push_ctx();
+  // Make sure everything symex has recorded so far is in the solver
+  flush_latest_instructions();
 
   // Convert the question (must be a bool).
   assert(is_bool_type(question));
   smt_astt q = conv.convert_ast(question);
 
-  // The proposition also needs to be guarded with the in-program assumptions,
-  // which are not necessarily going to be part of the state guard.
-  conv.assert_ast(assumpt_chain.back());
-
-  // Now, how to ask the question? Unfortunately the clever solver stuff won't
-  // negate the condition, it'll only give us a handle to it that it negates
-  // when we access. So, we have to make an assertion, check it, pop it, then
-  // check another.
-  // Those assertions are just is-the-prop-true, is-the-prop-false. Valid
-  // results are true, false, both.
-  push_ctx();
-  conv.assert_ast(q);
-  smt_convt::resultt res1 = conv.dec_solve();
-  pop_ctx();
-  push_ctx();
-  conv.assert_ast(conv.invert_ast(q));
-  smt_convt::resultt res2 = conv.dec_solve();
-  pop_ctx();
+  // Ask whether the question can be true, and whether it can be false, under
+  // the in-program assumptions, which are not necessarily going to be part
+  // of the state guard. Neither is asserted, so nothing needs undoing.
+  smt_convt::ast_vec assumptions;
+  assumptions.push_back(assumpt_chain.back());
+  assumptions.push_back(q);
+  smt_convt::resultt res1 = conv.dec_solve_assuming(assumptions);
+
+  assumptions.back() = conv.invert_ast(q);
+  smt_convt::resultt res2 = conv.dec_solve_assuming(assumptions);
 
   // So; which result?
+  tvt final_res;
   if(
     res1 == smt_convt::P_ERROR || res1 == smt_convt::P_SMTLIB ||
     res2 == smt_convt::P_ERROR || res2 == smt_convt::P_SMTLIB)
@@ -521,8 +740,9 @@ tvt runtime_encoded_equationt::ask_solver_question(const expr2tc &question)
   }
   else if(res1 == smt_convt::P_SATISFIABLE && res2 == smt_convt::P_SATISFIABLE)
   {
-    // Both ways are satisfiable; result is unknown.
-    final_res = tvt(tvt::TV_UNKNOWN);
+    // Both ways are satisfiable; result is unknown. More constraints may
+    // decide it later, so don't remember it.
+    return tvt(tvt::TV_UNKNOWN);
   }
   else if(
     res1 == smt_convt::P_SATISFIABLE && res2 == smt_convt::P_UNSATISFIABLE)
@@ -538,12 +758,10 @@ tvt runtime_encoded_equationt::ask_solver_question(const expr2tc &question)
   }
   else
   {
-    pop_ctx();
     throw dual_unsat_exception();
   }
 
-  // We have our result; pop off the questions / formula we've asked.
-  pop_ctx();
-
+  answered.emplace(question, final_res);
+  answered_log.push_back(question);
   return final_res;
 }
@@ -9,20 +9,85 @@ Author: Daniel Kroening, kroening@kroening.com
 #ifndef CPROVER_BASIC_SYMEX_EQUATION_H
 #define CPROVER_BASIC_SYMEX_EQUATION_H
 
+#include <climits>
 #include <cstdint>
 #include <cstdio>
 #include <cstring>
+#include <deque>
 #include <goto-programs/goto_program.h>
 #include <goto-symex/goto_trace.h>
 #include <goto-symex/symex_target.h>
 #include <list>
 #include <map>
+#include <unordered_map>
 #include <solvers/smt/smt_conv.h>
 #include <util/config.h>
 #include <util/irep2.h>
 #include <util/namespace.h>
+#include <util/time_stopping.h>
 #include <vector>
 
+/** Tree of the call stacks the SSA steps were recorded in.
+ *  Each node is a stack frame plus the node of the frames below it, and
+ *  nodes are shared: steps in the same function activation all refer to the
+ *  same node, so a stack trace costs one id per step instead of one frame per
+ *  level of the call stack. */
+class stack_treet
+{
+public:
+  static const unsigned int no_node = UINT_MAX;
+
+  /** @param trace Stack frames, most recent first
+   *  @return Node of the most recent frame, or no_node for an empty trace */
+  unsigned int intern(const std::vector<stack_framet> &trace);
+
+  /** @return The frames from node down, most recent first */
+  std::vector<stack_framet> get(unsigned int node) const;
+
+  size_t size() const
+  {
+    return nodes.size();
+  }
+
+  /** Forget the nodes created after the tree had the given size */
+  void truncate(size_t size);
+
+protected:
+  class nodet
+  {
+  public:
+    stack_framet frame;
+    unsigned int parent;
+  };
+
+  // Frames are told apart as stack_framet::_cmp does, plus the thread
+  class keyt
+  {
+  public:
+    unsigned int parent;
+    unsigned int function;
+    unsigned int location;
+    unsigned int thread;
+
+    bool operator==(const keyt &ref) const
+    {
+      return parent == ref.parent && function == ref.function &&
+             location == ref.location && thread == ref.thread;
+    }
+  };
+
+  class key_hasht
+  {
+  public:
+    size_t operator()(const keyt &key) const;
+  };
+
+  static keyt get_key(unsigned int parent, const stack_framet &frame);
+
+  std::vector<nodet> nodes;
+  std::unordered_map<keyt, unsigned int, key_hasht> index;
+};
+
 class symex_target_equationt : public symex_targett
 {
 public:
@@ -33,6 +98,8 @@ public:
     debug_print = config.options.get_bool_option("symex-ssa-trace");
     ssa_trace = config.options.get_bool_option("ssa-trace");
     ssa_smt_trace = config.options.get_bool_option("ssa-smt-trace");
+    release_encoded =
+      config.options.get_bool_option("release-encoded-steps");
   }
 
   // assignment to a variable - must be symbol
@@ -80,22 +147,38 @@ public:
     const sourcet &source) override;
 
   virtual void convert(smt_convt &smt_conv);
+
+  /** Convert the equation without asserting that any claim is violated.
+   *  Used to check each claim on its own, as with --multi-property.
+   *  @param smt_conv Solver converter to encode the SSA steps into
+   *  @param violations Receives one AST per claim, in SSA step order, that
+   *         is true when that claim is violated */
+  void convert_claims(smt_convt &smt_conv, smt_convt::ast_vec &violations);
+
+  /** Compute the hashes of the expressions in the SSA steps on several
+   *  threads. smt_convt looks up every expression it converts in its cache
+   *  by hash; doing the hashing beforehand takes that work off the single
+   *  thread that feeds the solver.
+   *  @param threads Number of threads to use, including the calling one
+   *  @return Time spent hashing, summed over all threads */
+  fine_timet hash_steps(unsigned int threads) const;
   void convert_internal_step(
     smt_convt &smt_conv,
     smt_astt &assumpt_ast,
     smt_convt::ast_vec &assertions,
     SSA_stept &s);
 
+  // Marks a step without an entry in one of the side tables below
+  static const unsigned int no_entry = UINT_MAX;
+
+  /** An SSA step. Only what the slicer and the encoder look at is kept here;
+   *  stack traces and output arguments, which are only needed to report a
+   *  counterexample, live in side tables of the equation, see
+   *  get_stack_trace and get_output. */
   class SSA_stept
   {
   public:
     sourcet source;
-    goto_trace_stept::typet type;
-
-    // One stack trace recorded per function activation record. Valid for
-    // assignment and assert steps only. In reverse order (most recent in idx
-    // 0).
-    std::vector<stack_framet> stack_trace;
 
     bool is_assert() const
     {
@@ -130,15 +213,21 @@ public:
 
     // for ASSUME/ASSERT
     expr2tc cond;
-    std::string comment;
-
-    // for OUTPUT
-    std::string format_string;
-    std::list<expr2tc> output_args;
+    irep_idt comment;
 
     // for conversion
     smt_astt guard_ast, cond_ast;
-    std::list<expr2tc> converted_output_args;
+
+    // for bidirectional search
+    unsigned loop_number;
+
+    // Node in the stack tree of the equation, or stack_treet::no_node
+    unsigned int stack_node;
+
+    // Entry in the outputs of the equation, or no_entry
+    unsigned int output_idx;
+
+    goto_trace_stept::typet type;
 
     // for slicing
     bool ignore;
@@ -146,10 +235,12 @@ public:
     // for visibility
     bool hidden;
 
-    // for bidirectional search
-    unsigned loop_number;
-
-    SSA_stept() : ignore(false), hidden(false)
+    SSA_stept()
+      : loop_number(0),
+        stack_node(stack_treet::no_node),
+        output_idx(no_entry),
+        ignore(false),
+        hidden(false)
     {
     }
 
@@ -161,6 +252,37 @@ public:
     void dump() const;
   };
 
+  /** Format and arguments of an OUTPUT step */
+  class SSA_outputt
+  {
+  public:
+    std::string format_string;
+    std::list<expr2tc> output_args;
+
+    // for conversion
+    std::list<expr2tc> converted_output_args;
+  };
+
+  /** One stack trace recorded per function activation record. Valid for
+   *  assignment and assert steps only. In reverse order (most recent in idx
+   *  0). Rebuilt from the stack tree on each call. */
+  std::vector<stack_framet> get_stack_trace(const SSA_stept &step) const
+  {
+    return stack_tree.get(step.stack_node);
+  }
+
+  const SSA_outputt &get_output(const SSA_stept &step) const
+  {
+    assert(step.output_idx != no_entry);
+    return outputs[step.output_idx];
+  }
+
+  SSA_outputt &get_output(const SSA_stept &step)
+  {
+    assert(step.output_idx != no_entry);
+    return outputs[step.output_idx];
+  }
+
   unsigned count_ignored_SSA_steps() const
   {
     unsigned i = 0;
@@ -170,18 +292,75 @@ public:
     return i;
   }
 
-  typedef std::list<SSA_stept> SSA_stepst;
+  // Steps are stored in chunks, so appending never moves them
+  typedef std::deque<SSA_stept> SSA_stepst;
   SSA_stepst SSA_steps;
 
-  SSA_stepst::iterator get_SSA_step(unsigned s)
+  stack_treet stack_tree;
+  std::vector<SSA_outputt> outputs;
+
+  /** Number of steps and of side table entries at some point, to cut the
+   *  equation back to with truncate */
+  class markt
   {
-    SSA_stepst::iterator it = SSA_steps.begin();
-    for(; s != 0; s--)
+  public:
+    size_t steps;
+    size_t stack_nodes;
+    size_t outputs;
+  };
+
+  markt get_mark() const
+  {
+    markt mark;
+    mark.steps = SSA_steps.size();
+    mark.stack_nodes = stack_tree.size();
+    mark.outputs = outputs.size();
+    return mark;
+  }
+
+  /** Drop the steps recorded since mark was taken */
+  void truncate(const markt &mark);
+
+  /** Encoding state carried across the equations for increasing bounds, with
+   *  --incremental-solver. The leading SSA steps an equation shares with the
+   *  previous one stay encoded at the base context level of the solver; the
+   *  remaining steps are pushed on top of them. */
+  class encoded_prefixt
+  {
+  public:
+    encoded_prefixt() : encoded(0), assumpt_ast(nullptr), pushed(false)
     {
-      assert(it != SSA_steps.end());
-      it++;
     }
-    return it;
+
+    // Steps of the last equation converted, and their output arguments; the
+    // first `encoded` ones are encoded at the base context level
+    SSA_stepst steps;
+    std::vector<SSA_outputt> outputs;
+    unsigned int encoded;
+
+    // Conjunction of the assumptions and the negated assertions among the
+    // encoded steps
+    smt_astt assumpt_ast;
+    smt_convt::ast_vec violations;
+
+    // Whether the rest of the last equation is still pushed on the solver
+    bool pushed;
+  };
+
+  /** Convert the equation on top of what earlier equations left in `prefix`
+   *  on the same solver, encoding only the steps not already there. The top
+   *  context stays pushed so that a counterexample can still be read, and is
+   *  popped by the next call.
+   *  @param smt_conv Solver converter the prefix was encoded into
+   *  @param prefix Encoding state from the previous equations
+   *  @return False if the equation doesn't start with the encoded prefix;
+   *          nothing was converted then, and a fresh solver is needed */
+  bool convert_prefixed(smt_convt &smt_conv, encoded_prefixt &prefix);
+
+  SSA_stepst::iterator get_SSA_step(unsigned s)
+  {
+    assert(s <= SSA_steps.size());
+    return SSA_steps.begin() + s;
   }
 
   void output(std::ostream &out) const;
@@ -192,6 +371,8 @@ public:
   void clear()
   {
     SSA_steps.clear();
+    stack_tree.truncate(0);
+    outputs.clear();
   }
 
   unsigned int clear_assertions();
@@ -211,6 +392,12 @@ protected:
   bool debug_print;
   bool ssa_trace;
   bool ssa_smt_trace;
+
+  // Drop the expressions of each step once it is converted; see
+  // release_step
+  bool release_encoded;
+
+  void release_step(SSA_stept &step);
 };
 
 class runtime_encoded_equationt : public symex_target_equationt
@@ -235,17 +422,20 @@ public:
   smt_convt &conv;
   std::list<smt_convt::ast_vec> assert_vec_list;
   std::list<smt_astt> assumpt_chain;
-  std::list<SSA_stepst::iterator> scoped_end_points;
-  SSA_stepst::iterator cvt_progress;
+  std::list<markt> scoped_end_points;
+
+  /** Questions answered definitely so far. Encoding more steps only adds
+   *  constraints, so an answer stays right until the context it was given in
+   *  is popped; answered_log lists the questions in the order they were
+   *  answered, and answered_marks its length at each push. */
+  std::unordered_map<expr2tc, tvt, irep2_hash> answered;
+  std::vector<expr2tc> answered_log;
+  std::list<size_t> answered_marks;
+
+  // Number of leading steps already converted
+  size_t cvt_progress;
 };
 
-extern inline bool operator<(
-  const symex_target_equationt::SSA_stepst::const_iterator a,
-  const symex_target_equationt::SSA_stepst::const_iterator b)
-{
-  return &(*a) < &(*b);
-}
-
 std::ostream &
 operator<<(std::ostream &out, const symex_target_equationt::SSA_stept &step);
 std::ostream &
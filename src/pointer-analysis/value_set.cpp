@@ -133,14 +133,20 @@ bool value_sett::make_union(const value_sett::valuest &new_values, bool keepnew)
 {
   bool result = false;
 
+  // Merging a copy that neither side has modified changes nothing
+  if(values.shares_root(new_values))
+    return false;
+
   // Iterate over all new values; if they're in the current value set, merge
   // them. If not, only merge it in if keepnew is true.
   for(const auto &new_value : new_values)
   {
-    valuest::iterator it2 = values.find(new_value.first);
+    // Only look the entry up for writing when the merge changes it: that
+    // unshares it from the other copies of this value set.
+    valuest::const_iterator it = values.find(new_value.first);
 
     // If the new variable isnt in this' set,
-    if(it2 == values.end())
+    if(it == values.end())
     {
       // We always track these when merging value sets, as these store data
       // that's transfered back and forth between function calls. So, the
@@ -159,16 +165,43 @@ bool value_sett::make_union(const value_sett::valuest &new_values, bool keepnew)
     }
 
     // The variable was in this' set, merge the values.
-    entryt &e = it2->second;
+    const entryt &e = it->second;
     const entryt &new_e = new_value.second;
 
-    if(make_union(e.object_map, new_e.object_map))
-      result = true;
+    // Both sets still share this entry
+    if(&e == &new_e)
+      continue;
+
+    if(!adds_objects(e.object_map, new_e.object_map))
+      continue;
+
+    valuest::iterator it2 = values.find_mutable(new_value.first);
+    make_union(it2->second.object_map, new_e.object_map);
+    result = true;
   }
 
   return result;
 }
 
+bool value_sett::adds_objects(const object_mapt &dest, const object_mapt &src)
+  const
+{
+  for(const auto &obj : src)
+  {
+    object_mapt::const_iterator it = dest.find(obj.first);
+    if(it == dest.end())
+      return true;
+
+    // Would insert have to widen the offset record in dest?
+    object_mapt tmp;
+    tmp.insert(*it);
+    if(insert(tmp, obj.first, obj.second))
+      return true;
+  }
+
+  return false;
+}
+
 bool value_sett::make_union(object_mapt &dest, const object_mapt &src) const
 {
   bool result = false;
@@ -1069,9 +1102,10 @@ void value_sett::do_free(const expr2tc &op)
     }
   }
 
-  // mark these as 'may be invalid'
-  // this, unfortunately, destroys the sharing
-  for(auto &value : values)
+  // mark these as 'may be invalid'. Only entries that change are written
+  // back, so that the others stay shared with saved states.
+  std::vector<std::pair<irep_idt, object_mapt>> updates;
+  for(const auto &value : values)
   {
     object_mapt new_object_map;
 
@@ -1105,8 +1139,12 @@ void value_sett::do_free(const expr2tc &op)
     }
 
     if(changed)
-      value.second.object_map = new_object_map;
+      updates.emplace_back(value.first, new_object_map);
   }
+
+  for(auto &update : updates)
+    values.find_mutable(update.first)->second.object_map =
+      std::move(update.second);
 }
 
 void value_sett::assign_rec(
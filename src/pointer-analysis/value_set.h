@@ -15,6 +15,7 @@ Author: Daniel Kroening, kroening@kroening.com
 #include <util/mp_arith.h>
 #include <util/namespace.h>
 #include <util/numbering.h>
+#include <util/persistent_map.h>
 #include <util/type_byte_size.h>
 
 /** Code for tracking "value sets" across assignments in ESBMC.
@@ -252,8 +253,9 @@ public:
 
   /** Type of the value-set containing structure. A hash map mapping variables
    *  to an entryt, storing the value set of objects a variable might point
-   *  at. */
-  typedef std::unordered_map<irep_idt, entryt, irep_id_hash> valuest;
+   *  at. It's persistent, so that the copies symex saves at each goto share
+   *  all the entries they haven't modified. */
+  typedef persistent_mapt<irep_idt, entryt, irep_id_hash> valuest;
 
   /** Get the natural alignment unit of a reference to e. I don't know a more
    *  appropriate term, but if we were to have an offset into e, then what is
@@ -508,6 +510,11 @@ public:
    *  @return True when dest has been modified. */
   bool make_union(object_mapt &dest, const object_mapt &src) const;
 
+  /** Check whether make_union(dest, src) would change dest.
+   *  @return True if src points at anything dest doesn't, or with an offset
+   *          dest's records don't cover. */
+  bool adds_objects(const object_mapt &dest, const object_mapt &src) const;
+
   /** Given another value set tracking object's storage, read all value set
    *  records out and merge them into this object's.
    *  @param new_values Stored set of value sets to merge into this object.
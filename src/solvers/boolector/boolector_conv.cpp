@@ -36,6 +36,14 @@ boolector_convt::boolector_convt(bool int_encoding, const namespacet &ns)
   btor = boolector_new();
   boolector_set_opt(btor, BTOR_OPT_MODEL_GEN, 1);
   boolector_set_opt(btor, BTOR_OPT_AUTO_CLEANUP, 1);
+
+  // --multi-property calls the solver repeatedly on the same formula, while
+  // --incremental-solver and --smt-during-symex push and pop contexts on it
+  if(
+    config.options.get_bool_option("multi-property") ||
+    config.options.get_bool_option("incremental-solver") ||
+    config.options.get_bool_option("smt-during-symex"))
+    boolector_set_opt(btor, BTOR_OPT_INCREMENTAL, 1);
   boolector_set_abort(error_handler);
 }
 
@@ -60,6 +68,38 @@ smt_convt::resultt boolector_convt::dec_solve()
   return P_ERROR;
 }
 
+smt_convt::resultt
+boolector_convt::dec_solve_assuming(const ast_vec &assumptions)
+{
+  pre_solve();
+
+  // Assumptions only last until the next call to boolector_sat
+  for(smt_astt a : assumptions)
+    boolector_assume(btor, to_solver_smt_ast<btor_smt_ast>(a)->a);
+
+  int result = boolector_sat(btor);
+
+  if(result == BOOLECTOR_SAT)
+    return P_SATISFIABLE;
+
+  if(result == BOOLECTOR_UNSAT)
+    return P_UNSATISFIABLE;
+
+  return P_ERROR;
+}
+
+void boolector_convt::push_ctx()
+{
+  smt_convt::push_ctx();
+  boolector_push(btor, 1);
+}
+
+void boolector_convt::pop_ctx()
+{
+  boolector_pop(btor, 1);
+  smt_convt::pop_ctx();
+}
+
 const std::string boolector_convt::solver_text()
 {
   std::string ss = "Boolector ";
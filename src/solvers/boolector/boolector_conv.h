@@ -27,8 +27,12 @@ public:
   ~boolector_convt() override;
 
   resultt dec_solve() override;
+  resultt dec_solve_assuming(const ast_vec &assumptions) override;
   const std::string solver_text() override;
 
+  void push_ctx() override;
+  void pop_ctx() override;
+
   void assert_ast(smt_astt a) override;
 
   smt_astt mk_bvadd(smt_astt a, smt_astt b) override;
@@ -28,6 +28,14 @@ cvc_convt::cvc_convt(bool int_encoding, const namespacet &ns)
   // Already initialized stuff in the constructor list,
   smt.setOption("produce-models", true);
   smt.setOption("produce-assertions", true);
+
+  // --multi-property calls the solver repeatedly on the same formula, while
+  // --incremental-solver and --smt-during-symex push and pop contexts on it
+  if(
+    config.options.get_bool_option("multi-property") ||
+    config.options.get_bool_option("incremental-solver") ||
+    config.options.get_bool_option("smt-during-symex"))
+    smt.setOption("incremental", true);
 }
 
 smt_convt::resultt cvc_convt::dec_solve()
@@ -44,6 +52,24 @@ smt_convt::resultt cvc_convt::dec_solve()
   return P_UNSATISFIABLE;
 }
 
+smt_convt::resultt cvc_convt::dec_solve_assuming(const ast_vec &assumptions)
+{
+  pre_solve();
+
+  std::vector<CVC4::Expr> exprs;
+  for(smt_astt a : assumptions)
+    exprs.push_back(to_solver_smt_ast<cvc_smt_ast>(a)->a);
+
+  CVC4::Result r = smt.checkSat(exprs);
+  if(r.isSat())
+    return P_SATISFIABLE;
+
+  if(r.isUnknown())
+    return P_ERROR;
+
+  return P_UNSATISFIABLE;
+}
+
 bool cvc_convt::get_bool(smt_astt a)
 {
   auto const *ca = to_solver_smt_ast<cvc_smt_ast>(a);
@@ -94,11 +120,22 @@ expr2tc cvc_convt::get_array_elem(
   smt_astt tmpast = mk_smt_bv(BigInt(index), mk_bv_sort(orig_w));
   auto const *tmpa = to_solver_smt_ast<cvc_smt_ast>(tmpast);
   CVC4::Expr e = em.mkExpr(CVC4::kind::SELECT, carray->a, tmpa->a);
-  delete tmpast;
 
   return get_by_ast(subtype, new_ast(e, convert_sort(subtype)));
 }
 
+void cvc_convt::push_ctx()
+{
+  smt_convt::push_ctx();
+  smt.push();
+}
+
+void cvc_convt::pop_ctx()
+{
+  smt.pop();
+  smt_convt::pop_ctx();
+}
+
 const std::string cvc_convt::solver_text()
 {
   std::stringstream ss;
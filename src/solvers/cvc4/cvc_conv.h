@@ -19,8 +19,12 @@ public:
   ~cvc_convt() override = default;
 
   smt_convt::resultt dec_solve() override;
+  smt_convt::resultt dec_solve_assuming(const ast_vec &assumptions) override;
   const std::string solver_text() override;
 
+  void push_ctx() override;
+  void pop_ctx() override;
+
   bool get_bool(smt_astt a) override;
   BigInt get_bv(smt_astt a, bool is_signed) override;
   ieee_floatt get_fpbv(smt_astt a) override;
@@ -593,16 +593,10 @@ void array_convt::pop_array_ctx()
   }
 
   for(auto &indexes : array_indexes)
-  {
-    auto &ctx_level_idx = indexes.get<1>();
-    ctx_level_idx.erase(target_ctx);
-  }
+    indexes.pop(ctx->ctx_level);
 
   for(auto &indexes : expr_index_map)
-  {
-    auto &ctx_level_idx = indexes.get<1>();
-    ctx_level_idx.erase(target_ctx);
-  }
+    indexes.pop(ctx->ctx_level);
 
   for(auto &relation : array_relations)
   {
@@ -770,8 +764,7 @@ void array_convt::add_new_indexes()
   unsigned int arrid = 0;
   for(const idx_record_containert &rec : array_indexes)
   {
-    auto &ctx_index = rec.get<1>();
-    auto pair = ctx_index.equal_range(ctx->ctx_level);
+    auto pair = rec.level_range(ctx->ctx_level);
 
     if(pair.first == pair.second)
     {
@@ -984,8 +977,7 @@ void array_convt::add_array_equalities()
       continue;
 
     idx_record_containert &idxs = array_indexes[it.second.arr1_id];
-    idx_record_containert::nth_index<1>::type &ctx_level_idx = idxs.get<1>();
-    auto pair = ctx_level_idx.equal_range(ctx->ctx_level);
+    auto pair = idxs.level_range(ctx->ctx_level);
 
     if(pair.first == pair.second)
       // No indexes added in this context level, no additional constraints
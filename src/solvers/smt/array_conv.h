@@ -16,8 +16,12 @@
 //
 // As a result, this particular class is due some serious maintenence.
 
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index_container.hpp>
 #include <set>
 #include <solvers/smt/smt_conv.h>
+#include <solvers/smt/smt_level_cache.h>
 #include <util/irep2.h>
 
 static inline bool is_unbounded_array(const smt_sort *s)
@@ -104,14 +108,11 @@ public:
   };
   typedef struct index_map_rec index_map_rect;
 
-  typedef boost::multi_index_container<
+  typedef smt_level_cachet<
     index_map_rect,
-    boost::multi_index::indexed_by<
-      boost::multi_index::hashed_unique<
-        BOOST_MULTI_INDEX_MEMBER(index_map_rect, expr2tc, idx)>,
-      boost::multi_index::ordered_non_unique<
-        BOOST_MULTI_INDEX_MEMBER(index_map_rect, unsigned int, ctx_level),
-        std::greater<unsigned int>>>>
+    expr2tc,
+    &index_map_rect::idx,
+    irep2_hash>
     index_map_containert;
 
   array_convt(smt_convt *_ctx);
@@ -228,12 +229,12 @@ public:
 
   inline array_ast *new_ast(smt_sortt _s)
   {
-    return new array_ast(this, ctx, _s);
+    return new(ctx) array_ast(this, ctx, _s);
   }
 
   inline array_ast *new_ast(smt_sortt _s, const std::vector<smt_astt> &_a)
   {
-    return new array_ast(this, ctx, _s, _a);
+    return new(ctx) array_ast(this, ctx, _s, _a);
   }
 
   void push_array_ctx() override;
@@ -254,14 +255,7 @@ public:
     unsigned int ctx_level;
   };
 
-  typedef boost::multi_index_container<
-    idx_record,
-    boost::multi_index::indexed_by<
-      boost::multi_index::hashed_unique<
-        BOOST_MULTI_INDEX_MEMBER(idx_record, expr2tc, idx)>,
-      boost::multi_index::ordered_non_unique<
-        BOOST_MULTI_INDEX_MEMBER(idx_record, unsigned int, ctx_level),
-        std::greater<unsigned int>>>>
+  typedef smt_level_cachet<idx_record, expr2tc, &idx_record::idx, irep2_hash>
     idx_record_containert;
   std::vector<idx_record_containert> array_indexes;
 
@@ -39,6 +39,18 @@ public:
   smt_ast(smt_convt *ctx, smt_sortt s);
   virtual ~smt_ast() = default;
 
+  /** smt_asts live in their context's arena, and are created with
+   *  new(ctx). They're destroyed in place by the context when the level they
+   *  were created in is popped, which releases their memory all at once;
+   *  they're never deleted. */
+  static void *operator new(size_t size, smt_convt *ctx);
+  static void operator delete(void *, smt_convt *)
+  {
+  }
+  static void operator delete(void *)
+  {
+  }
+
   // "this" is the true operand.
   virtual smt_astt ite(smt_convt *ctx, smt_astt cond, smt_astt falseop) const;
 
@@ -0,0 +1,121 @@
+#ifndef SOLVERS_SMT_SMT_AST_ARENA_H_
+#define SOLVERS_SMT_SMT_AST_ARENA_H_
+
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/** Bump allocator for the smt_asts of one smt_convt.
+ *  Allocations are carved out of fixed size blocks in order. Each solver
+ *  context level is a contiguous stretch of that sequence, so popping a level
+ *  is a matter of moving the bump pointer back to where the push left it;
+ *  blocks are kept for reuse by the next level, and only freed along with the
+ *  arena. Nothing is ever freed individually. */
+class smt_ast_arenat
+{
+public:
+  smt_ast_arenat() : in_use(0), offset(block_size), allocated(0)
+  {
+  }
+
+  smt_ast_arenat(const smt_ast_arenat &ref) = delete;
+  smt_ast_arenat &operator=(const smt_ast_arenat &ref) = delete;
+
+  void *allocate(size_t size)
+  {
+    size = (size + alignment - 1) & ~(alignment - 1);
+    assert(size <= block_size && "smt_ast too large for the arena");
+
+    if(offset + size > block_size)
+      next_block();
+
+    void *ptr = blocks[in_use - 1].get() + offset;
+    offset += size;
+    allocated += size;
+    return ptr;
+  }
+
+  void push()
+  {
+    markt m;
+    m.in_use = in_use;
+    m.offset = offset;
+    m.allocated = allocated;
+    marks.push_back(m);
+  }
+
+  /** Release everything allocated since the last push */
+  void pop()
+  {
+    assert(!marks.empty());
+    const markt &m = marks.back();
+    in_use = m.in_use;
+    offset = m.offset;
+    allocated = m.allocated;
+    marks.pop_back();
+  }
+
+  /** Release everything, keeping the blocks */
+  void clear()
+  {
+    marks.clear();
+    in_use = 0;
+    offset = block_size;
+    allocated = 0;
+  }
+
+  /** Bytes allocated at each context level, outermost first */
+  std::vector<size_t> level_bytes() const
+  {
+    std::vector<size_t> res;
+    size_t start = 0;
+    for(const markt &m : marks)
+    {
+      res.push_back(m.allocated - start);
+      start = m.allocated;
+    }
+    res.push_back(allocated - start);
+    return res;
+  }
+
+  size_t bytes_allocated() const
+  {
+    return allocated;
+  }
+
+  size_t bytes_reserved() const
+  {
+    return blocks.size() * block_size;
+  }
+
+protected:
+  static const size_t block_size = 1 << 16;
+  static const size_t alignment = alignof(std::max_align_t);
+
+  void next_block()
+  {
+    if(in_use == blocks.size())
+      blocks.emplace_back(new char[block_size]);
+    in_use++;
+    offset = 0;
+  }
+
+  class markt
+  {
+  public:
+    size_t in_use;
+    size_t offset;
+    size_t allocated;
+  };
+
+  std::vector<std::unique_ptr<char[]>> blocks;
+  // Number of blocks allocated from, the last one being the current one
+  size_t in_use;
+  // Offset of the first free byte in the current block
+  size_t offset;
+  size_t allocated;
+  std::vector<markt> marks;
+};
+
+#endif /* SOLVERS_SMT_SMT_AST_ARENA_H_ */
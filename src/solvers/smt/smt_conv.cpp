@@ -7,6 +7,7 @@
 #include <util/base_type.h>
 #include <util/c_types.h>
 #include <util/expr_util.h>
+#include <util/i2string.h>
 
 // Helpers extracted from z3_convt.
 
@@ -135,10 +136,12 @@ void smt_convt::set_fp_conv(fp_convt *iface)
 
 void smt_convt::delete_all_asts()
 {
-  // Erase all the remaining asts in the live ast vector.
+  // Destroy all the remaining asts in the live ast vector.
   for(auto *ast : live_asts)
-    delete ast;
+    ast->~smt_ast();
   live_asts.clear();
+  live_asts_sizes.clear();
+  ast_arena.clear();
 }
 
 void smt_convt::smt_post_init()
@@ -180,6 +183,7 @@ void smt_convt::push_ctx()
   renumber_map.push_back(renumber_map.back());
 
   live_asts_sizes.push_back(live_asts.size());
+  ast_arena.push();
 
   ctx_level++;
 }
@@ -188,8 +192,7 @@ void smt_convt::pop_ctx()
 {
   // Erase everything in caches added in the current context level. Everything
   // before the push is going to disappear.
-  smt_cachet::nth_index<1>::type &cache_numindex = smt_cache.get<1>();
-  cache_numindex.erase(ctx_level);
+  smt_cache.pop(ctx_level - 1);
   pointer_logic.pop_back();
   addr_space_sym_num.pop_back();
   addr_space_data.pop_back();
@@ -197,19 +200,30 @@ void smt_convt::pop_ctx()
 
   ctx_level--;
 
-  // Go through all the asts created since the last push and delete them.
-
+  // Go through all the asts created since the last push and destroy them.
   for(unsigned int idx = live_asts_sizes.back(); idx < live_asts.size(); idx++)
-    delete live_asts[idx];
+    live_asts[idx]->~smt_ast();
 
   // And reset the storage back to that point.
   live_asts.resize(live_asts_sizes.back());
   live_asts_sizes.pop_back();
+  ast_arena.pop();
 
   array_api->pop_array_ctx();
   tuple_api->pop_tuple_ctx();
 }
 
+smt_convt::resultt smt_convt::dec_solve_assuming(const ast_vec &assumptions)
+{
+  push_ctx();
+  for(smt_astt a : assumptions)
+    assert_ast(a);
+
+  resultt res = dec_solve();
+  pop_ctx();
+  return res;
+}
+
 smt_astt smt_convt::invert_ast(smt_astt a)
 {
   assert(a->sort->id == SMT_SORT_BOOL);
@@ -1126,7 +1140,7 @@ smt_sortt smt_convt::convert_sort(const type2tc &type)
   smt_sort_cachet::const_iterator it = sort_cache.find(type);
   if(it != sort_cache.end())
   {
-    return it->second;
+    return it->sort;
   }
 
   smt_sortt result = nullptr;
@@ -1218,7 +1232,8 @@ smt_sortt smt_convt::convert_sort(const type2tc &type)
     abort();
   }
 
-  sort_cache.insert(smt_sort_cachet::value_type(type, result));
+  smt_sort_cache_entryt entry = {type, result, 0};
+  sort_cache.insert(entry);
   return result;
 }
 
@@ -1331,7 +1346,7 @@ smt_astt smt_convt::convert_terminal(const expr2tc &expr)
     {
       const symbol2t &sym = to_symbol2t(expr);
       return tuple_api->mk_tuple_symbol(
-        sym.get_symbol_name(), convert_sort(sym.type));
+        get_symbol_name(sym), convert_sort(sym.type));
     }
 
     if(is_array_type(expr))
@@ -1346,7 +1361,7 @@ smt_astt smt_convt::convert_terminal(const expr2tc &expr)
 
     // Just a normal symbol. Possibly an array symbol.
     const symbol2t &sym = to_symbol2t(expr);
-    std::string name = sym.get_symbol_name();
+    const std::string &name = get_symbol_name(sym);
 
     smt_sortt sort = convert_sort(sym.type);
 
@@ -1369,9 +1384,24 @@ smt_astt smt_convt::convert_terminal(const expr2tc &expr)
 std::string smt_convt::mk_fresh_name(const std::string &tag)
 {
   std::string new_name = "smt_conv::" + tag;
-  std::stringstream ss;
-  ss << new_name << fresh_map[new_name]++;
-  return ss.str();
+  unsigned int num = fresh_map[new_name]++;
+  return new_name + i2string(num);
+}
+
+const std::string &smt_convt::get_symbol_name(const symbol2t &sym)
+{
+  auto it = symbol_names.emplace(symbol_keyt(sym), std::string());
+  if(it.second)
+    it.first->second = sym.get_symbol_name();
+
+  return it.first->second;
+}
+
+smt_astt smt_convt::mk_assumption_literal(smt_astt a)
+{
+  smt_astt lit = mk_fresh(boolean_sort, "assumption::");
+  assert_ast(imply_ast(lit, a));
+  return lit;
 }
 
 smt_astt smt_convt::mk_fresh(
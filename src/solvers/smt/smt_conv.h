@@ -1,13 +1,11 @@
 #ifndef _ESBMC_PROP_SMT_SMT_CONV_H_
 #define _ESBMC_PROP_SMT_SMT_CONV_H_
 
-#include <boost/multi_index/hashed_index.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index_container.hpp>
 #include <cstdint>
 #include <solvers/prop/literal.h>
 #include <solvers/prop/pointer_logic.h>
+#include <solvers/smt/smt_ast_arena.h>
+#include <solvers/smt/smt_level_cache.h>
 #include <util/irep2_utils.h>
 #include <util/message.h>
 #include <util/namespace.h>
@@ -139,7 +137,7 @@ public:
   smt_astt
   new_solver_ast(typename the_solver_ast::solver_ast_type ast, smt_sortt sort)
   {
-    return new the_solver_ast(this, ast, sort);
+    return new(this) the_solver_ast(this, ast, sort);
   }
 
   /** Primary constructor. After construction, smt_post_init must be called
@@ -245,6 +243,15 @@ public:
    *  @return Result code of the call to the solver. */
   virtual resultt dec_solve() = 0;
 
+  /** Solve the formula given to the solver, as dec_solve does, with some
+   *  extra formulas assumed to be true for this call only. Solvers that
+   *  support it natively keep everything they learnt in between calls; the
+   *  default implementation asserts the assumptions in a context pushed for
+   *  the call, after which no model is left to read.
+   *  @param assumptions Boolean sorted ASTs that must hold.
+   *  @return Result code of the call to the solver. */
+  virtual resultt dec_solve_assuming(const ast_vec &assumptions);
+
   void pre_solve();
 
   /** Get the satisfying assignment using the type.
@@ -559,6 +566,16 @@ public:
   /** Create a previously un-used variable name with the prefix given in tag */
   std::string mk_fresh_name(const std::string &tag);
 
+  /** Solver name of an SSA symbol. It's built once per symbol and kept in
+   *  symbol_names, so the reference (and its c_str) stays valid for the
+   *  lifetime of this converter. */
+  const std::string &get_symbol_name(const symbol2t &sym);
+
+  /** Create a fresh boolean symbol and assert that it implies a. Assuming the
+   *  symbol then amounts to assuming a, for solvers that only accept symbols
+   *  as assumptions. */
+  smt_astt mk_assumption_literal(smt_astt a);
+
   void renumber_symbol_address(
     const expr2tc &guard,
     const expr2tc &addr_symbol,
@@ -763,22 +780,32 @@ public:
 
   struct smt_cache_entryt
   {
-    const expr2tc val;
+    expr2tc val;
     smt_astt ast;
-    unsigned int level;
+    unsigned int ctx_level;
   };
 
-  typedef boost::multi_index_container<
+  typedef smt_level_cachet<
     smt_cache_entryt,
-    boost::multi_index::indexed_by<
-      boost::multi_index::hashed_unique<
-        BOOST_MULTI_INDEX_MEMBER(smt_cache_entryt, const expr2tc, val)>,
-      boost::multi_index::ordered_non_unique<
-        BOOST_MULTI_INDEX_MEMBER(smt_cache_entryt, unsigned int, level),
-        std::greater<unsigned int>>>>
+    expr2tc,
+    &smt_cache_entryt::val,
+    irep2_hash>
     smt_cachet;
 
-  typedef std::unordered_map<type2tc, smt_sortt, type2_hash> smt_sort_cachet;
+  // Sorts aren't freed on pop, so their cache entries are all at level zero
+  struct smt_sort_cache_entryt
+  {
+    type2tc type;
+    smt_sortt sort;
+    unsigned int ctx_level;
+  };
+
+  typedef smt_level_cachet<
+    smt_sort_cache_entryt,
+    type2tc,
+    &smt_sort_cache_entryt::type,
+    type2_hash>
+    smt_sort_cachet;
 
   // Members
   /** Number of un-popped context pushes encountered so far. */
@@ -829,7 +856,11 @@ public:
    *  with a particular prefix, this map stores how many times that prefix has
    *  been used, and thus what number should be appended to make the name
    *  unique. */
-  std::map<std::string, unsigned int> fresh_map;
+  std::unordered_map<std::string, unsigned int> fresh_map;
+
+  /** Solver names of the SSA symbols converted so far, see get_symbol_name.
+   *  Not popped: a symbol's name doesn't depend on the context level. */
+  std::unordered_map<symbol_keyt, std::string, symbol_key_hash> symbol_names;
 
   /** Integer recording how many times the address space allocation record
    *  array has been modified. Essentially, this is like the SSA variable
@@ -853,12 +884,14 @@ public:
   std::vector<renumber_mapt> renumber_map;
 
   /** Lifetime tracking of smt ast's. When a context is pop'd, all the ASTs
-   *  created in that context are freed. */
+   *  created in that context are destroyed. */
   std::vector<smt_astt> live_asts;
   /** Accounting of live_asts for push/pop. Records the number of pointers
    *  contained when a push occurred. On pop, the live_asts vector is reset
    *  back to that point. */
   std::vector<unsigned int> live_asts_sizes;
+  /** Memory of the ASTs in live_asts, pushed and popped with them */
+  smt_ast_arenat ast_arena;
 
   tuple_iface *tuple_api;
   array_iface *array_api;
@@ -870,6 +903,11 @@ public:
 };
 
 // Define here to enable inlining
+inline void *smt_ast::operator new(size_t size, smt_convt *ctx)
+{
+  return ctx->ast_arena.allocate(size);
+}
+
 inline smt_ast::smt_ast(smt_convt *ctx, smt_sortt s) : sort(s), context(ctx)
 {
   assert(sort != nullptr);
@@ -0,0 +1,173 @@
+#ifndef SOLVERS_SMT_SMT_LEVEL_CACHE_H_
+#define SOLVERS_SMT_SMT_LEVEL_CACHE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/** Hash table of records tagged with the solver context level that created
+ *  them, for the caches that have to forget a level's records when it's
+ *  popped.
+ *
+ *  Records are kept in a vector in insertion order. As the context level only
+ *  grows between pops, that vector is sorted by level, and popping a level
+ *  is removing a suffix of it: the vector doubles as the undo log. Lookups go
+ *  through a flat open-addressing table of indexes into the vector, with
+ *  linear probing. Records are never modified or removed otherwise, and
+ *  inserting a record whose key is already present does nothing.
+ *
+ *  Record must have an unsigned int ctx_level member; key is the member
+ *  holding its key. */
+template <class Record, class Key, Key Record::*key, class Hash>
+class smt_level_cachet
+{
+public:
+  typedef typename std::vector<Record>::const_iterator const_iterator;
+
+  smt_level_cachet() : slots(16, 0)
+  {
+  }
+
+  const_iterator begin() const
+  {
+    return records.begin();
+  }
+
+  const_iterator end() const
+  {
+    return records.end();
+  }
+
+  size_t size() const
+  {
+    return records.size();
+  }
+
+  bool empty() const
+  {
+    return records.empty();
+  }
+
+  const_iterator find(const Key &k) const
+  {
+    size_t pos = find_slot(k, Hash()(k));
+    if(slots[pos] == 0)
+      return records.end();
+
+    return records.begin() + (slots[pos] - 1);
+  }
+
+  std::pair<const_iterator, bool> insert(const Record &rec)
+  {
+    assert(records.empty() || records.back().ctx_level <= rec.ctx_level);
+
+    size_t hash = Hash()(rec.*key);
+    size_t pos = find_slot(rec.*key, hash);
+    if(slots[pos] != 0)
+      return std::make_pair(records.begin() + (slots[pos] - 1), false);
+
+    records.push_back(rec);
+    hashes.push_back(hash);
+    slots[pos] = records.size();
+
+    // Keep the load factor under one half
+    if(records.size() * 2 > slots.size())
+      grow();
+
+    return std::make_pair(records.end() - 1, true);
+  }
+
+  /** Forget all the records of levels above level */
+  void pop(unsigned int level)
+  {
+    while(!records.empty() && records.back().ctx_level > level)
+    {
+      erase_slot(find_slot(records.back().*key, hashes.back()));
+      records.pop_back();
+      hashes.pop_back();
+    }
+  }
+
+  /** The records of one context level, which are contiguous */
+  std::pair<const_iterator, const_iterator> level_range(unsigned int level)
+    const
+  {
+    const_iterator first = records.begin(), last = records.end();
+    while(first != last && (last - 1)->ctx_level > level)
+      last--;
+    for(first = last; first != records.begin(); first--)
+      if((first - 1)->ctx_level != level)
+        break;
+
+    return std::make_pair(first, last);
+  }
+
+  void clear()
+  {
+    records.clear();
+    hashes.clear();
+    slots.assign(16, 0);
+  }
+
+protected:
+  size_t find_slot(const Key &k, size_t hash) const
+  {
+    size_t mask = slots.size() - 1;
+    size_t pos = hash & mask;
+    while(slots[pos] != 0)
+    {
+      uint32_t idx = slots[pos] - 1;
+      if(hashes[idx] == hash && records[idx].*key == k)
+        break;
+      pos = (pos + 1) & mask;
+    }
+
+    return pos;
+  }
+
+  // Backward shift deletion: pull later records of the probe sequence into
+  // the hole, so that lookups never need tombstones.
+  void erase_slot(size_t hole)
+  {
+    size_t mask = slots.size() - 1;
+    slots[hole] = 0;
+
+    size_t pos = (hole + 1) & mask;
+    for(; slots[pos] != 0; pos = (pos + 1) & mask)
+    {
+      size_t home = hashes[slots[pos] - 1] & mask;
+      // Can the record at pos move back into the hole?
+      bool movable = (hole <= pos) ? (home <= hole || home > pos)
+                                   : (home <= hole && home > pos);
+      if(movable)
+      {
+        slots[hole] = slots[pos];
+        slots[pos] = 0;
+        hole = pos;
+      }
+    }
+  }
+
+  void grow()
+  {
+    slots.assign(slots.size() * 2, 0);
+    size_t mask = slots.size() - 1;
+    for(uint32_t idx = 0; idx < records.size(); idx++)
+    {
+      size_t pos = hashes[idx] & mask;
+      while(slots[pos] != 0)
+        pos = (pos + 1) & mask;
+      slots[pos] = idx + 1;
+    }
+  }
+
+  std::vector<Record> records;
+  // Hash of the key of each record
+  std::vector<size_t> hashes;
+  // One more than the index of the record in each slot; zero when free
+  std::vector<uint32_t> slots;
+};
+
+#endif /* SOLVERS_SMT_SMT_LEVEL_CACHE_H_ */
@@ -206,7 +206,7 @@ void smt_convt::renumber_symbol_address(
   const expr2tc &new_size)
 {
   const symbol2t &sym = to_symbol2t(addr_symbol);
-  std::string str = sym.get_symbol_name();
+  const std::string &str = get_symbol_name(sym);
 
   // Two different approaches if we do or don't have an address-of pointer
   // variable already.
@@ -477,7 +477,7 @@ smt_astt smt_convt::convert_addr_of(const expr2tc &expr)
   if(is_symbol2t(obj.ptr_obj))
   {
     const symbol2t &symbol = to_symbol2t(obj.ptr_obj);
-    return convert_identifier_pointer(obj.ptr_obj, symbol.get_symbol_name());
+    return convert_identifier_pointer(obj.ptr_obj, get_symbol_name(symbol));
   }
 
   if(is_constant_string2t(obj.ptr_obj))
@@ -14,7 +14,7 @@ smt_astt smt_tuple_node_flattener::tuple_create(const expr2tc &structdef)
   // Add a . suffix because this is of tuple type.
   name += ".";
 
-  tuple_node_smt_ast *result = new tuple_node_smt_ast(
+  tuple_node_smt_ast *result = new(ctx) tuple_node_smt_ast(
     *this, ctx, ctx->convert_sort(structdef->type), name);
   result->elements.resize(structdef->get_num_sub_exprs());
 
@@ -40,7 +40,7 @@ smt_astt smt_tuple_node_flattener::tuple_fresh(smt_sortt s, std::string name)
     return array_conv.mk_array_symbol(name, s, subtype);
   }
 
-  return new tuple_node_smt_ast(*this, ctx, s, name);
+  return new(ctx) tuple_node_smt_ast(*this, ctx, s, name);
 }
 
 smt_astt
@@ -62,14 +62,14 @@ smt_tuple_node_flattener::mk_tuple_symbol(const std::string &name, smt_sortt s)
     name2 += ".";
 
   assert(s->id != SMT_SORT_ARRAY);
-  return new tuple_node_smt_ast(*this, ctx, s, name2);
+  return new(ctx) tuple_node_smt_ast(*this, ctx, s, name2);
 }
 
 smt_astt smt_tuple_node_flattener::mk_tuple_array_symbol(const expr2tc &expr)
 {
   // Exactly the same as creating a tuple symbol, but for arrays.
   const symbol2t &sym = to_symbol2t(expr);
-  std::string name = sym.get_symbol_name() + "[]";
+  std::string name = ctx->get_symbol_name(sym) + "[]";
   smt_sortt sort = ctx->convert_sort(ctx->flatten_array_type(sym.type));
   smt_sortt subtype =
     ctx->convert_sort(ctx->get_flattened_array_subtype(sym.type));
@@ -128,8 +128,6 @@ smt_astt smt_tuple_node_flattener::tuple_array_create(
 expr2tc smt_tuple_node_flattener::tuple_get(const expr2tc &expr)
 {
   assert(is_symbol2t(expr) && "Non-symbol in smtlib expr get()");
-  const symbol2t &sym = to_symbol2t(expr);
-  std::string name = sym.get_symbol_name();
 
   tuple_node_smt_astt a = to_tuple_node_ast(ctx->convert_ast(expr));
   return tuple_get_rec(a);
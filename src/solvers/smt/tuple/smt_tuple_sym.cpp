@@ -16,7 +16,7 @@ smt_astt smt_tuple_sym_flattener::tuple_create(const expr2tc &structdef)
   name += ".";
 
   smt_astt result =
-    new tuple_sym_smt_ast(ctx, ctx->convert_sort(structdef->type), name);
+    new(ctx) tuple_sym_smt_ast(ctx, ctx->convert_sort(structdef->type), name);
 
   for(unsigned int i = 0; i < structdef->get_num_sub_exprs(); i++)
   {
@@ -34,9 +34,9 @@ smt_astt smt_tuple_sym_flattener::tuple_fresh(smt_sortt s, std::string name)
     (name == "") ? ctx->mk_fresh_name("tuple_fresh::") + "." : name;
 
   if(s->id == SMT_SORT_ARRAY)
-    return new array_sym_smt_ast(ctx, s, n);
+    return new(ctx) array_sym_smt_ast(ctx, s, n);
 
-  return new tuple_sym_smt_ast(ctx, s, n);
+  return new(ctx) tuple_sym_smt_ast(ctx, s, n);
 }
 
 smt_astt
@@ -50,16 +50,16 @@ smt_tuple_sym_flattener::mk_tuple_symbol(const std::string &name, smt_sortt s)
     name2 += ".";
 
   assert(s->id != SMT_SORT_ARRAY);
-  return new tuple_sym_smt_ast(ctx, s, name2);
+  return new(ctx) tuple_sym_smt_ast(ctx, s, name2);
 }
 
 smt_astt smt_tuple_sym_flattener::mk_tuple_array_symbol(const expr2tc &expr)
 {
   // Exactly the same as creating a tuple symbol, but for arrays.
   const symbol2t &sym = to_symbol2t(expr);
-  std::string name = sym.get_symbol_name() + "[]";
+  std::string name = ctx->get_symbol_name(sym) + "[]";
   smt_sortt sort = ctx->convert_sort(sym.type);
-  return new array_sym_smt_ast(ctx, sort, name);
+  return new(ctx) array_sym_smt_ast(ctx, sort, name);
 }
 
 smt_astt smt_tuple_sym_flattener::tuple_array_create(
@@ -75,7 +75,7 @@ smt_astt smt_tuple_sym_flattener::tuple_array_create(
   // XXX - probably more efficient to update each member array, but not now.
   smt_sortt sort = ctx->convert_sort(array_type);
   std::string name = ctx->mk_fresh_name("tuple_array_create::") + ".";
-  smt_astt newsym = new array_sym_smt_ast(ctx, sort, name);
+  smt_astt newsym = new(ctx) array_sym_smt_ast(ctx, sort, name);
 
   // Check size
   const array_type2t &arr_type = to_array_type(array_type);
@@ -120,7 +120,7 @@ expr2tc smt_tuple_sym_flattener::tuple_get(const expr2tc &expr)
 {
   assert(is_symbol2t(expr) && "Non-symbol in smtlib expr get()");
   const symbol2t &sym = to_symbol2t(expr);
-  std::string name = sym.get_symbol_name();
+  const std::string &name = ctx->get_symbol_name(sym);
 
   const type2tc &thetype =
     (is_structure_type(expr->type)) ? expr->type : ctx->pointer_struct;
@@ -174,7 +174,7 @@ smt_astt smt_tuple_sym_flattener::tuple_array_of(
   symbol2tc tuple_arr_of_sym(arrtype, irep_idt(name));
 
   smt_sortt sort = ctx->convert_sort(arrtype);
-  smt_astt newsym = new array_sym_smt_ast(ctx, sort, name);
+  smt_astt newsym = new(ctx) array_sym_smt_ast(ctx, sort, name);
 
   assert(subtype.members.size() == data.datatype_members.size());
   for(unsigned long i = 0; i < subtype.members.size(); i++)
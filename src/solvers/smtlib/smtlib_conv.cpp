@@ -1,14 +1,22 @@
 // "Standards" workaround
 #define __STDC_FORMAT_MACROS
 
+#include <cctype>
+#include <cerrno>
 #include <cinttypes>
+#include <cstdarg>
+#include <cstring>
+#include <list>
 #include <smtlib_conv.h>
 #include <smtlib.hpp>
 #include <smtlib_tok.hpp>
 #include <sstream>
 #ifndef _WIN32
+#include <fcntl.h>
+#include <sys/wait.h>
 #include <unistd.h>
 #endif
+#include <util/i2string.h>
 const std::string smtlib_convt::smt_func_name_table[expr2t::end_expr_id] = {
   "hack_func_id",
   "invalid_func_id",
@@ -110,8 +118,28 @@ smt_convt *create_new_smtlib_solver(
   return conv;
 }
 
+namespace
+{
+/** A solver process that a destroyed smtlib_convt left behind, reset and
+ *  ready for the next one to use */
+class idle_solvert
+{
+public:
+  std::string cmd;
+  FILE *out_stream;
+  FILE *in_stream;
+  std::string solver_name;
+  std::string solver_version;
+};
+
+std::list<idle_solvert> idle_solvers;
+} // namespace
+
 smtlib_convt::smtlib_convt(bool int_encoding, const namespacet &_ns)
-  : smt_convt(int_encoding, _ns), array_iface(false, false), fp_convt(this)
+  : smt_convt(int_encoding, _ns),
+    array_iface(false, false),
+    fp_convt(this),
+    compressor_pid(0)
 {
   temp_sym_count.push_back(1);
   std::string cmd;
@@ -129,8 +157,12 @@ smtlib_convt::smtlib_convt(bool int_encoding, const namespacet &_ns)
       abort();
     }
 
-    // Open a file, do nothing else.
-    out_stream = fopen(cmd.c_str(), "w");
+    // Open a file, do nothing else. A formula written to a .zst file gets
+    // compressed on its way there.
+    if(cmd.size() > 4 && cmd.compare(cmd.size() - 4, 4, ".zst") == 0)
+      out_stream = open_compressed_output(cmd);
+    else
+      out_stream = fopen(cmd.c_str(), "w");
     if(!out_stream)
     {
       std::cerr << "Failed to open \"" << cmd << "\"" << std::endl;
@@ -141,18 +173,13 @@ smtlib_convt::smtlib_convt(bool int_encoding, const namespacet &_ns)
     solver_name = "Text output";
     solver_version = "";
 
-    fprintf(out_stream, "(set-logic %s)\n", logic.c_str());
-    fprintf(out_stream, "(set-info :status unknown)\n");
-    fprintf(out_stream, "(set-option :produce-models true)\n");
+    emit("(set-logic %s)\n", logic.c_str());
+    emit("(set-info :status unknown)\n");
+    emit("(set-option :produce-models true)\n");
 
     return;
   }
 
-  // Setup: open a pipe to the smtlib solver. There seems to be no standard C++
-  // way of opening a stream from an fd, so use C file streams.
-
-  int inpipe[2], outpipe[2];
-
   cmd = config.options.get_option("smtlib-solver-prog");
   if(cmd == "")
   {
@@ -160,6 +187,35 @@ smtlib_convt::smtlib_convt(bool int_encoding, const namespacet &_ns)
               << std::endl;
     abort();
   }
+
+  solver_cmd = cmd;
+
+  // Reuse a solver process a previous converter has finished with, if there
+  // is one: k-induction creates a converter per step.
+  for(auto it = idle_solvers.begin(); it != idle_solvers.end(); it++)
+  {
+    if(it->cmd != cmd)
+      continue;
+
+    out_stream = it->out_stream;
+    in_stream = it->in_stream;
+    solver_name = it->solver_name;
+    solver_version = it->solver_version;
+    idle_solvers.erase(it);
+
+    smtlib_tokin = in_stream;
+
+    emit("(set-logic %s)\n", logic.c_str());
+    emit("(set-info :status unknown)\n");
+    emit("(set-option :produce-models true)\n");
+    return;
+  }
+
+  // Setup: open a pipe to the smtlib solver. There seems to be no standard C++
+  // way of opening a stream from an fd, so use C file streams.
+
+  int inpipe[2], outpipe[2];
+
 #ifdef _WIN32
   // TODO: The current implementation uses UNIX Process
   std::cerr << "smtlib works only in unix systems\n";
@@ -209,13 +265,13 @@ smtlib_convt::smtlib_convt(bool int_encoding, const namespacet &_ns)
   // Point lexer input at output stream
   smtlib_tokin = in_stream;
 
-  fprintf(out_stream, "(set-logic %s)\n", logic.c_str());
-  fprintf(out_stream, "(set-info :status unknown)\n");
-  fprintf(out_stream, "(set-option :produce-models true)\n");
+  emit("(set-logic %s)\n", logic.c_str());
+  emit("(set-info :status unknown)\n");
+  emit("(set-option :produce-models true)\n");
 
   // Fetch solver name and version.
-  fprintf(out_stream, "(get-info :name)\n");
-  fflush(out_stream);
+  emit("(get-info :name)\n");
+  flush_output();
   smtlib_send_start_code = 1;
   smtlibparse(TOK_START_INFO);
 
@@ -241,8 +297,8 @@ smtlib_convt::smtlib_convt(bool int_encoding, const namespacet &_ns)
   delete smtlib_output;
 
   // Duplicate / boilerplate;
-  fprintf(out_stream, "(get-info :version)\n");
-  fflush(out_stream);
+  emit("(get-info :version)\n");
+  flush_output();
   smtlib_send_start_code = 1;
   smtlibparse(TOK_START_INFO);
 
@@ -268,6 +324,160 @@ smtlib_convt::smtlib_convt(bool int_encoding, const namespacet &_ns)
 smtlib_convt::~smtlib_convt()
 {
   delete_all_asts();
+
+  if(in_stream == nullptr)
+  {
+    // Text output: make sure it all reaches the file
+    write_output();
+    fclose(out_stream);
+#ifndef _WIN32
+    if(compressor_pid != 0)
+    {
+      int status;
+      waitpid(compressor_pid, &status, 0);
+      if(!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+        std::cerr << "zstd failed to compress the SMT formula" << std::endl;
+    }
+#endif
+    return;
+  }
+
+  // Wipe the solver's state and keep the process for the next converter
+  emit("(reset)\n");
+  flush_output();
+
+  idle_solvert idle;
+  idle.cmd = solver_cmd;
+  idle.out_stream = out_stream;
+  idle.in_stream = in_stream;
+  idle.solver_name = solver_name;
+  idle.solver_version = solver_version;
+  idle_solvers.push_back(idle);
+}
+
+FILE *smtlib_convt::open_compressed_output(const std::string &filename)
+{
+#ifdef _WIN32
+  std::cerr << "Compressed smtlib output works only in unix systems\n";
+  abort();
+#else
+  int fd = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if(fd < 0)
+    return nullptr;
+
+  int zpipe[2];
+  if(pipe(zpipe) != 0)
+  {
+    std::cerr << "Couldn't open a pipe for zstd" << std::endl;
+    abort();
+  }
+
+  // The child reports a failed exec through this pipe; a successful exec
+  // closes it, so the parent reads nothing.
+  int status_pipe[2];
+  if(pipe(status_pipe) != 0)
+  {
+    std::cerr << "Couldn't open a pipe for zstd" << std::endl;
+    abort();
+  }
+  fcntl(status_pipe[1], F_SETFD, FD_CLOEXEC);
+
+  compressor_pid = fork();
+  if(compressor_pid == 0)
+  {
+    close(zpipe[1]);
+    close(status_pipe[0]);
+    dup2(zpipe[0], STDIN_FILENO);
+    dup2(fd, STDOUT_FILENO);
+    close(zpipe[0]);
+    close(fd);
+
+    execlp("zstd", "zstd", "-q", "-c", NULL);
+    int err = errno;
+    while(write(status_pipe[1], &err, sizeof(err)) < 0 && errno == EINTR)
+      ;
+    _exit(127);
+  }
+
+  close(zpipe[0]);
+  close(fd);
+  close(status_pipe[1]);
+
+  int err;
+  ssize_t len = read(status_pipe[0], &err, sizeof(err));
+  close(status_pipe[0]);
+  if(len > 0)
+  {
+    // Nothing would drain the pipe, writing the formula would die of SIGPIPE
+    waitpid(compressor_pid, nullptr, 0);
+    close(zpipe[1]);
+    unlink(filename.c_str());
+    std::cerr << "Couldn't run zstd to compress \"" << filename
+              << "\": " << strerror(err) << std::endl;
+    abort();
+  }
+
+  return fdopen(zpipe[1], "w");
+#endif
+}
+
+void smtlib_convt::forget_idle_solvers()
+{
+  // Their output was flushed when they were reset, closing writes nothing
+  for(idle_solvert &idle : idle_solvers)
+  {
+    fclose(idle.out_stream);
+    fclose(idle.in_stream);
+  }
+
+  idle_solvers.clear();
+}
+
+void smtlib_convt::emit(const char *fmt, ...)
+{
+  // Format straight into the buffer if the result is short enough, which it
+  // nearly always is, otherwise make room and format again.
+  char buf[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  assert(len >= 0);
+
+  if(static_cast<size_t>(len) < sizeof(buf))
+  {
+    out_buf.append(buf, len);
+  }
+  else
+  {
+    size_t start = out_buf.size();
+    out_buf.resize(start + len + 1);
+    va_start(ap, fmt);
+    vsnprintf(&out_buf[start], len + 1, fmt, ap);
+    va_end(ap);
+    out_buf.resize(start + len);
+  }
+
+  if(out_buf.size() >= out_buf_limit)
+    write_output();
+}
+
+void smtlib_convt::write_output()
+{
+  if(fwrite(out_buf.data(), 1, out_buf.size(), out_stream) != out_buf.size())
+  {
+    std::cerr << "Failed to write to smtlib solver or output file"
+              << std::endl;
+    abort();
+  }
+
+  out_buf.clear();
+}
+
+void smtlib_convt::flush_output()
+{
+  write_output();
+  fflush(out_stream);
 }
 
 std::string smtlib_convt::sort_to_string(const smt_sort *s) const
@@ -342,8 +552,7 @@ smtlib_convt::emit_terminal_ast(const smtlib_smt_ast *ast, std::string &output)
     return 0;
   case SMT_FUNC_SYMBOL:
     // All symbols to be emitted braced within |'s
-    ss << "|" << ast->symname << "|";
-    output = ss.str();
+    output = "|" + ast->symname + "|";
     return 0;
   default:
     std::cerr << "Invalid terminal AST kind" << std::endl;
@@ -351,8 +560,10 @@ smtlib_convt::emit_terminal_ast(const smtlib_smt_ast *ast, std::string &output)
   }
 }
 
-unsigned int
-smtlib_convt::emit_ast(const smtlib_smt_ast *ast, std::string &output)
+unsigned int smtlib_convt::emit_ast(
+  const smtlib_smt_ast *ast,
+  std::string &output,
+  bool define)
 {
   unsigned int brace_level = 0;
   std::string args[4];
@@ -370,45 +581,102 @@ smtlib_convt::emit_ast(const smtlib_smt_ast *ast, std::string &output)
     // Continue.
   }
 
+  // Subterms that have been defined already, or bound by a let that
+  // encloses everything emitted after it in this term, are referred to by
+  // name.
+  auto defined = defined_terms.find(ast);
+  if(defined != defined_terms.end())
+  {
+    output = defined->name;
+    return 0;
+  }
+
+  auto bound = let_names.find(ast);
+  if(bound != let_names.end())
+  {
+    output = bound->second;
+    return 0;
+  }
+
   for(unsigned long int i = 0; i < ast->args.size(); i++)
-    brace_level +=
-      emit_ast(static_cast<const smtlib_smt_ast *>(ast->args[i]), args[i]);
+    brace_level += emit_ast(
+      static_cast<const smtlib_smt_ast *>(ast->args[i]), args[i], define);
 
   // Get a temporary sym name
   unsigned int tempnum = temp_sym_count.back()++;
-  std::stringstream ss;
-  ss << "?x" << tempnum;
-  std::string tempname = ss.str();
+  std::string tempname = "?x" + i2string(tempnum);
 
-  // Emit a let, assigning the result of this AST func to the sym.
-  // For some reason let requires a double-braced operand.
-  fprintf(out_stream, "(let ((%s (", tempname.c_str());
+  if(define)
+  {
+    // Define a nullary function as the result of this AST func.
+    out_buf += "(define-fun ";
+    out_buf += tempname;
+    out_buf += " () ";
+    out_buf += sort_to_string(ast->sort);
+    out_buf += " (";
+  }
+  else
+  {
+    // Emit a let, assigning the result of this AST func to the sym.
+    // For some reason let requires a double-braced operand.
+    out_buf += "(let ((";
+    out_buf += tempname;
+    out_buf += " (";
+  }
 
   // This asts function
   assert(static_cast<int>(ast->kind) <= static_cast<int>(expr2t::end_expr_id));
   if(ast->kind == SMT_FUNC_EXTRACT)
   {
     // Extract is an indexed function
-    fprintf(
-      out_stream, "(_ extract %d %d)", ast->extract_high, ast->extract_low);
+    emit("(_ extract %d %d)", ast->extract_high, ast->extract_low);
   }
   else
   {
-    fprintf(out_stream, "%s", smt_func_name_table[ast->kind].c_str());
+    out_buf += smt_func_name_table[ast->kind];
   }
 
   // Its operands
   for(unsigned long int i = 0; i < ast->args.size(); i++)
-    fprintf(out_stream, " %s", args[i].c_str());
+  {
+    out_buf += ' ';
+    out_buf += args[i];
+  }
+
+  output = tempname;
+  if(define)
+  {
+    emit("))\n");
+
+    smtlib_defined_termt def;
+    def.ast = ast;
+    def.name = tempname;
+    def.ctx_level = ctx_level;
+    defined_terms.insert(def);
+    return brace_level;
+  }
 
   // End func enclosing brace, then operand to let (two braces).
-  fprintf(out_stream, ")))\n");
+  emit(")))\n");
 
   // We end with one additional brace level.
-  output = tempname;
+  let_names[ast] = tempname;
   return brace_level + 1;
 }
 
+unsigned int smtlib_convt::emit_term(smt_astt a)
+{
+  let_names.clear();
+
+  std::string output;
+  unsigned int brace_level =
+    emit_ast(static_cast<const smtlib_smt_ast *>(a), output, false);
+
+  // Emit the final temporary symbol - this is what the term evaluates to.
+  out_buf += output;
+  return brace_level;
+}
+
 smt_convt::resultt smtlib_convt::dec_solve()
 {
   pre_solve();
@@ -418,10 +686,10 @@ smt_convt::resultt smtlib_convt::dec_solve()
   // Emit constraints
   // check-sat
 
-  fprintf(out_stream, "(check-sat)\n");
+  emit("(check-sat)\n");
 
   // Flush out command, starting model check
-  fflush(out_stream);
+  flush_output();
 
   // If we're just outputing to a file, this is where we terminate.
   if(in_stream == nullptr)
@@ -454,74 +722,213 @@ smt_convt::resultt smtlib_convt::dec_solve()
   }
 }
 
-BigInt smtlib_convt::get_bv(smt_astt a, bool is_signed)
+void smtlib_convt::dump_smt()
 {
-  // This should always be a symbol.
-  const smtlib_smt_ast *sa = static_cast<const smtlib_smt_ast *>(a);
-  assert(sa->kind == SMT_FUNC_SYMBOL && "Non-symbol in smtlib expr get_bv()");
-  std::string name = sa->symname;
+  // Everything asserted so far has been written to the output file already
+  if(in_stream != nullptr)
+  {
+    smt_convt::dump_smt();
+    return;
+  }
 
-  fprintf(out_stream, "(get-value (|%s|))\n", name.c_str());
-  fflush(out_stream);
-  smtlib_send_start_code = 1;
-  smtlibparse(TOK_START_VALUE);
+  emit("(check-sat)\n");
+  flush_output();
+  std::cout << "SMT formula written to " << config.options.get_option("output")
+            << std::endl;
+}
+
+/** Read one s-expression from the solver, as text */
+static std::string read_sexpr(FILE *in)
+{
+  std::string text;
+  int c;
+
+  do
+    c = getc(in);
+  while(c != EOF && isspace(c));
 
-  if(smtlib_output->token == TOK_KW_ERROR)
+  unsigned int depth = 0;
+  bool in_bars = false, in_string = false;
+  for(; c != EOF; c = getc(in))
   {
-    std::cerr << "Error from smtlib solver when fetching literal value: \""
-              << smtlib_output->data << "\"" << std::endl;
+    text += c;
+
+    if(in_bars)
+      in_bars = (c != '|');
+    else if(in_string)
+      in_string = (c != '"');
+    else if(c == '|')
+      in_bars = true;
+    else if(c == '"')
+      in_string = true;
+    else if(c == '(')
+      depth++;
+    else if(c == ')')
+      depth--;
+
+    if(depth == 0 && !in_bars && !in_string)
+    {
+      // End of a list, or of an atom that's followed by a delimiter
+      if(c == ')')
+        break;
+      int next = getc(in);
+      if(next == EOF || isspace(next) || next == '(' || next == ')')
+      {
+        ungetc(next, in);
+        break;
+      }
+      ungetc(next, in);
+    }
+  }
+
+  if(c == EOF)
+  {
+    std::cerr << "smtlib solver closed its output unexpectedly" << std::endl;
     abort();
   }
-  else if(smtlib_output->token != 0)
+
+  return text;
+}
+
+/** Skip one s-expression in text, starting at pos, and the whitespace
+ *  after it */
+static void skip_sexpr(const std::string &text, size_t &pos)
+{
+  unsigned int depth = 0;
+  bool in_bars = false, in_string = false;
+  for(; pos < text.size(); pos++)
   {
-    std::cerr << "Unrecognized response to get-value from smtlib solver"
-              << std::endl;
+    char c = text[pos];
+    if(in_bars)
+      in_bars = (c != '|');
+    else if(in_string)
+      in_string = (c != '"');
+    else if(c == '|')
+      in_bars = true;
+    else if(c == '"')
+      in_string = true;
+    else if(c == '(')
+      depth++;
+    else if(c == ')')
+    {
+      if(depth == 0)
+        break;
+      depth--;
+    }
+    else if(depth == 0 && isspace(c))
+      break;
+
+    if(depth == 0 && !in_bars && !in_string && c == ')')
+    {
+      pos++;
+      break;
+    }
   }
 
-  // Unpack our value from response list.
-  assert(
-    smtlib_output->sexpr_list.size() == 1 &&
-    "More than one response to "
-    "get-value from smtlib solver");
-  sexpr &response = *smtlib_output->sexpr_list.begin();
-  // Now we have a valuation pair. First is the symbol
-  assert(
-    response.sexpr_list.size() == 2 &&
-    "Expected 2 operands in "
-    "valuation_pair_list from smtlib solver");
-  std::list<sexpr>::iterator it = response.sexpr_list.begin();
-  sexpr &symname = *it++;
-  sexpr &respval = *it++;
-  if(!(symname.token == TOK_SIMPLESYM && symname.data == name))
+  while(pos < text.size() && isspace(text[pos]))
+    pos++;
+}
+
+std::string smtlib_convt::get_value_response()
+{
+  flush_output();
+  std::string text = read_sexpr(in_stream);
+
+  if(text.compare(0, 6, "(error") == 0)
   {
-    std::cerr << "smtlib solver returned different symbol from get-value";
+    std::cerr << "Error from smtlib solver when fetching literal value: "
+              << text << std::endl;
     abort();
   }
 
-  // Attempt to read an integer.
-  BigInt m;
-  if(respval.token == TOK_DECIMAL)
+  // The response is ((term value)): skip the echo of what we asked for, and
+  // return the value, which is all anything here looks at.
+  if(text.compare(0, 2, "((") != 0)
+  {
+    std::cerr << "Unrecognized response to get-value from smtlib solver: "
+              << text << std::endl;
+    abort();
+  }
+
+  size_t pos = 2;
+  while(pos < text.size() && isspace(text[pos]))
+    pos++;
+  skip_sexpr(text, pos);
+
+  size_t start = pos;
+  skip_sexpr(text, pos);
+  size_t end = pos;
+  while(end > start && isspace(text[end - 1]))
+    end--;
+
+  return text.substr(start, end - start);
+}
+
+/** Parse an integer or bitvector value from a get-value response */
+static bool
+parse_smtlib_int(const std::string &value, bool is_signed, BigInt &m)
+{
+  if(value.empty())
+    return false;
+
+  if(value.compare(0, 2, "#b") == 0)
+  {
+    m = binary2integer(value.substr(2), is_signed);
+    return true;
+  }
+
+  if(value.compare(0, 2, "#x") == 0)
   {
-    m = string2integer(respval.data);
+    m = string2integer(value.substr(2), 16);
+    return true;
   }
-  else if(respval.token == TOK_NUMERAL)
+
+  if(isdigit(value[0]))
   {
-    std::cerr << "Numeral value for integer symbol from smtlib solver"
-              << std::endl;
-    abort();
+    m = string2integer(value);
+    return true;
   }
-  else if(respval.token == TOK_HEXNUM)
+
+  // (_ bvN width)
+  if(value.compare(0, 5, "(_ bv") == 0)
   {
-    std::string data = respval.data.substr(2);
-    m = string2integer(data, 16);
+    size_t end = value.find(' ', 5);
+    if(end == std::string::npos)
+      return false;
+    m = string2integer(value.substr(5, end - 5));
+    return true;
   }
-  else if(respval.token == TOK_BINNUM)
+
+  // (- N)
+  if(value.compare(0, 3, "(- ") == 0)
   {
-    std::string data = respval.data.substr(2);
-    m = binary2integer(data, is_signed);
+    if(!parse_smtlib_int(value.substr(3, value.size() - 4), is_signed, m))
+      return false;
+    m.negate();
+    return true;
+  }
+
+  return false;
+}
+
+BigInt smtlib_convt::get_bv(smt_astt a, bool is_signed)
+{
+  // This should always be a symbol.
+  const smtlib_smt_ast *sa = static_cast<const smtlib_smt_ast *>(a);
+  assert(sa->kind == SMT_FUNC_SYMBOL && "Non-symbol in smtlib expr get_bv()");
+  const std::string &name = sa->symname;
+
+  emit("(get-value (|%s|))\n", name.c_str());
+  std::string value = get_value_response();
+
+  BigInt m;
+  if(!parse_smtlib_int(value, is_signed, m))
+  {
+    std::cerr << "Unrecognized value for integer symbol from smtlib solver: "
+              << value << std::endl;
+    abort();
   }
 
-  delete smtlib_output;
   return m;
 }
 
@@ -531,74 +938,20 @@ smtlib_convt::get_array_elem(smt_astt array, uint64_t index, const type2tc &t)
   // This should always be a symbol.
   const smtlib_smt_ast *sa = static_cast<const smtlib_smt_ast *>(array);
   assert(sa->kind == SMT_FUNC_SYMBOL && "Non-symbol in smtlib get_array_elem");
-  std::string name = sa->symname;
+  const std::string &name = sa->symname;
 
   // XXX -- double bracing this may be a Z3 ecentricity
   uint64_t domain_width = array->sort->get_domain_width();
-  fprintf(
-    out_stream,
+  emit(
     "(get-value ((select |%s| (_ bv%" PRIu64 " %" PRIu64 "))))\n",
     name.c_str(),
     index,
     domain_width);
-  fflush(out_stream);
-  smtlib_send_start_code = 1;
-  smtlibparse(TOK_START_VALUE);
-
-  if(smtlib_output->token == TOK_KW_ERROR)
-  {
-    std::cerr << "Error from smtlib solver when fetching literal value: \""
-              << smtlib_output->data << "\"" << std::endl;
-    abort();
-  }
-  else if(smtlib_output->token != 0)
-  {
-    std::cerr << "Unrecognized response to get-value from smtlib solver"
-              << std::endl;
-  }
-
-  // Unpack our value from response list.
-  assert(
-    smtlib_output->sexpr_list.size() == 1 &&
-    "More than one response to "
-    "get-value from smtlib solver");
-  sexpr &response = *smtlib_output->sexpr_list.begin();
-  // Now we have a valuation pair. First is the symbol
-  assert(
-    response.sexpr_list.size() == 2 &&
-    "Expected 2 operands in "
-    "valuation_pair_list from smtlib solver");
-  std::list<sexpr>::iterator it = response.sexpr_list.begin();
-  it++; // Echo of what we selected
-  sexpr &respval = *it++;
+  std::string value = get_value_response();
 
   // Attempt to read an integer.
   BigInt m;
-  bool was_integer = true;
-  if(respval.token == TOK_DECIMAL)
-  {
-    m = string2integer(respval.data);
-  }
-  else if(respval.token == TOK_NUMERAL)
-  {
-    std::cerr << "Numeral value for integer symbol from smtlib solver"
-              << std::endl;
-    abort();
-  }
-  else if(respval.token == TOK_HEXNUM)
-  {
-    std::string data = respval.data.substr(2);
-    m = string2integer(data, 16);
-  }
-  else if(respval.token == TOK_BINNUM)
-  {
-    std::string data = respval.data.substr(2);
-    m = string2integer(data, 2);
-  }
-  else
-  {
-    was_integer = false;
-  }
+  bool was_integer = parse_smtlib_int(value, false, m);
 
   // Generate the appropriate expr.
   expr2tc result;
@@ -631,38 +984,15 @@ smtlib_convt::get_array_elem(smt_astt array, uint64_t index, const type2tc &t)
   }
   else if(is_bool_type(t))
   {
-    if(respval.token == TOK_KW_TRUE)
-    {
+    if(value == "true" || value == "#b1")
       result = gen_true_expr();
-    }
-    else if(respval.token == TOK_KW_FALSE)
-    {
+    else if(value == "false" || value == "#b0")
       result = gen_false_expr();
-    }
-    else if(respval.token == TOK_BINNUM)
-    {
-      assert(
-        respval.data.size() == 3 &&
-        "Boolean-typed binary number should "
-        "be 3 characters long (e.g. #b0)");
-
-      std::string data = respval.data.substr(2);
-      if(data[0] == '0')
-        result = gen_false_expr();
-      else if(data[0] == '1')
-        result = gen_true_expr();
-      else
-      {
-        std::cerr << "Unrecognized boolean-typed binary number format";
-        std::cerr << std::endl;
-        abort();
-      }
-    }
     else
     {
-      std::cerr << "Unexpected token reading value of boolean symbol from "
-                   "smtlib solver"
-                << std::endl;
+      std::cerr << "Unexpected value of boolean symbol from smtlib solver: "
+                << value << std::endl;
+      abort();
     }
   }
   else
@@ -670,70 +1000,30 @@ smtlib_convt::get_array_elem(smt_astt array, uint64_t index, const type2tc &t)
     abort();
   }
 
-  delete smtlib_output;
   return result;
 }
 
 bool smtlib_convt::get_bool(smt_astt a)
 {
-  fprintf(out_stream, "(get-value (");
+  emit("(get-value (");
 
-  std::string output;
-  unsigned int brace_level =
-    emit_ast(static_cast<const smtlib_smt_ast *>(a), output);
-  fprintf(out_stream, "%s", output.c_str());
+  unsigned int brace_level = emit_term(a);
 
   // Emit a ton of end braces.
-  for(unsigned int i = 0; i < brace_level; i++)
-    fputc(')', out_stream);
-
-  fprintf(out_stream, "))\n");
-
-  fflush(out_stream);
-  smtlib_send_start_code = 1;
-  smtlibparse(TOK_START_VALUE);
-
-  if(smtlib_output->token == TOK_KW_ERROR)
-  {
-    std::cerr << "Error from smtlib solver when fetching literal value: \""
-              << smtlib_output->data << "\"" << std::endl;
-    abort();
-  }
-  else if(smtlib_output->token != 0)
-  {
-    std::cerr << "Unrecognized response to get-value from smtlib solver"
-              << std::endl;
-  }
+  out_buf.append(brace_level, ')');
 
-  // First layer: valuation pair list. Should have one item.
-  assert(
-    smtlib_output->sexpr_list.size() == 1 &&
-    "Unexpected number of "
-    "responses to get-value from smtlib solver");
-  sexpr &pair = *smtlib_output->sexpr_list.begin();
-  // Should have two entries
-  assert(
-    pair.sexpr_list.size() == 2 &&
-    "Valuation pair in smtlib get-value "
-    "output without two operands");
-  std::list<sexpr>::const_iterator it = pair.sexpr_list.begin();
-  const sexpr &first = *it++;
-  (void)first;
-  const sexpr &second = *it++;
-  //  assert(first.token == TOK_SIMPLESYM && first.data == ss.str() &&
-  //         "Unexpected valuation variable from smtlib solver");
+  emit("))\n");
 
   // And finally we have our value. It should be true or false.
-  bool result;
-  if(second.token == TOK_KW_TRUE)
-    result = true;
-  else if(second.token == TOK_KW_FALSE)
-    result = false;
-  else
-    abort();
-
-  delete smtlib_output;
-  return result;
+  std::string value = get_value_response();
+  if(value == "true")
+    return true;
+  if(value == "false")
+    return false;
+
+  std::cerr << "Unexpected value of boolean term from smtlib solver: "
+            << value << std::endl;
+  abort();
 }
 
 const std::string smtlib_convt::solver_text()
@@ -751,32 +1041,21 @@ void smtlib_convt::assert_ast(smt_astt a)
 {
   const smtlib_smt_ast *sa = static_cast<const smtlib_smt_ast *>(a);
 
-  // Encode an assertion
-  fprintf(out_stream, "(assert\n");
-
-  // The algorithm: descend through the AST operands, binding values to
-  // temporary symbols, then emit functions on those temporary symbols.
-  // All recursively. The non-trivial bit is tracking how many ending
-  // braces are required.
-  // This is inspired by the output from Z3 that I've seen.
+  // The algorithm: descend through the AST operands, defining a function
+  // for each subterm that hasn't been, in terms of the functions for its
+  // operands. Formulas are DAGs, which this keeps from being printed as
+  // trees, even across assertions.
   std::string output;
-  unsigned int brace_level = emit_ast(sa, output);
-
-  // Emit the final temporary symbol - this is what gets asserted.
-  fprintf(out_stream, "%s", output.c_str());
+  emit_ast(sa, output, true);
 
-  // Emit a ton of end braces.
-  for(unsigned int i = 0; i < brace_level; i++)
-    fputc(')', out_stream);
-
-  // Final brace for closing the 'assert'.
-  fprintf(out_stream, ")\n");
+  // Encode an assertion
+  emit("(assert %s)\n", output.c_str());
 }
 
 smt_astt smtlib_convt::mk_smt_int(const BigInt &theint)
 {
   smt_sortt s = mk_int_sort();
-  smtlib_smt_ast *a = new smtlib_smt_ast(this, s, SMT_FUNC_INT);
+  smtlib_smt_ast *a = new(this) smtlib_smt_ast(this, s, SMT_FUNC_INT);
   a->intval = theint;
   return a;
 }
@@ -784,21 +1063,22 @@ smt_astt smtlib_convt::mk_smt_int(const BigInt &theint)
 smt_astt smtlib_convt::mk_smt_real(const std::string &str)
 {
   smt_sortt s = mk_real_sort();
-  smtlib_smt_ast *a = new smtlib_smt_ast(this, s, SMT_FUNC_REAL);
+  smtlib_smt_ast *a = new(this) smtlib_smt_ast(this, s, SMT_FUNC_REAL);
   a->realval = str;
   return a;
 }
 
 smt_astt smtlib_convt::mk_smt_bv(const BigInt &theint, smt_sortt s)
 {
-  smtlib_smt_ast *a = new smtlib_smt_ast(this, s, SMT_FUNC_BVINT);
+  smtlib_smt_ast *a = new(this) smtlib_smt_ast(this, s, SMT_FUNC_BVINT);
   a->intval = theint;
   return a;
 }
 
 smt_astt smtlib_convt::mk_smt_bool(bool val)
 {
-  smtlib_smt_ast *a = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BOOL);
+  smtlib_smt_ast *a =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BOOL);
   a->boolval = val;
   return a;
 }
@@ -813,7 +1093,7 @@ smt_astt smtlib_convt::mk_array_symbol(
 
 smt_astt smtlib_convt::mk_smt_symbol(const std::string &name, const smt_sort *s)
 {
-  smtlib_smt_ast *a = new smtlib_smt_ast(this, s, SMT_FUNC_SYMBOL);
+  smtlib_smt_ast *a = new(this) smtlib_smt_ast(this, s, SMT_FUNC_SYMBOL);
   a->symname = name;
 
   symbol_tablet::iterator it = symbol_table.find(name);
@@ -829,8 +1109,7 @@ smt_astt smtlib_convt::mk_smt_symbol(const std::string &name, const smt_sort *s)
     return a;
 
   // As this is the first time, declare that symbol to the solver.
-  fprintf(
-    out_stream,
+  emit(
     "(declare-fun |%s| () %s)\n",
     name.c_str(),
     sort_to_string(s).c_str());
@@ -849,7 +1128,7 @@ smt_astt
 smtlib_convt::mk_extract(smt_astt a, unsigned int high, unsigned int low)
 {
   smt_sortt s = mk_bv_sort(high - low + 1);
-  smtlib_smt_ast *n = new smtlib_smt_ast(this, s, SMT_FUNC_EXTRACT);
+  smtlib_smt_ast *n = new(this) smtlib_smt_ast(this, s, SMT_FUNC_EXTRACT);
   n->extract_high = high;
   n->extract_low = low;
   n->args.push_back(a);
@@ -885,7 +1164,8 @@ smt_astt smtlib_convt::mk_zero_ext(smt_astt a, unsigned int topwidth)
 
 smt_astt smtlib_convt::mk_concat(smt_astt a, smt_astt b)
 {
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_CONCAT);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_CONCAT);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -896,7 +1176,7 @@ smt_astt smtlib_convt::mk_ite(smt_astt cond, smt_astt t, smt_astt f)
   assert(cond->sort->id == SMT_SORT_BOOL);
   assert(t->sort->get_data_width() == f->sort->get_data_width());
 
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, t->sort, SMT_FUNC_ITE);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, t->sort, SMT_FUNC_ITE);
   ast->args.push_back(cond);
   ast->args.push_back(t);
   ast->args.push_back(f);
@@ -915,7 +1195,7 @@ void smtlib_convt::push_ctx()
   smt_convt::push_ctx();
   temp_sym_count.push_back(temp_sym_count.back());
 
-  fprintf(out_stream, "(push 1)\n");
+  emit("(push 1)\n");
 }
 
 smt_astt smtlib_convt::mk_add(smt_astt a, smt_astt b)
@@ -923,7 +1203,7 @@ smt_astt smtlib_convt::mk_add(smt_astt a, smt_astt b)
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
   assert(b->sort->id == SMT_SORT_INT || b->sort->id == SMT_SORT_REAL);
   assert(a->sort->id == b->sort->id);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_ADD);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_ADD);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -934,7 +1214,7 @@ smt_astt smtlib_convt::mk_bvadd(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVADD);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVADD);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -945,7 +1225,7 @@ smt_astt smtlib_convt::mk_sub(smt_astt a, smt_astt b)
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
   assert(b->sort->id == SMT_SORT_INT || b->sort->id == SMT_SORT_REAL);
   assert(a->sort->id == b->sort->id);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_SUB);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_SUB);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -956,7 +1236,7 @@ smt_astt smtlib_convt::mk_bvsub(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVSUB);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVSUB);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -967,7 +1247,7 @@ smt_astt smtlib_convt::mk_mul(smt_astt a, smt_astt b)
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
   assert(b->sort->id == SMT_SORT_INT || b->sort->id == SMT_SORT_REAL);
   assert(a->sort->id == b->sort->id);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_MUL);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_MUL);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -978,7 +1258,7 @@ smt_astt smtlib_convt::mk_bvmul(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVMUL);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVMUL);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -989,7 +1269,7 @@ smt_astt smtlib_convt::mk_mod(smt_astt a, smt_astt b)
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
   assert(b->sort->id == SMT_SORT_INT || b->sort->id == SMT_SORT_REAL);
   assert(a->sort->id == b->sort->id);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_MOD);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_MOD);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1000,7 +1280,8 @@ smt_astt smtlib_convt::mk_bvsmod(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVSMOD);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVSMOD);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1011,7 +1292,8 @@ smt_astt smtlib_convt::mk_bvumod(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVUMOD);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVUMOD);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1022,7 +1304,7 @@ smt_astt smtlib_convt::mk_div(smt_astt a, smt_astt b)
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
   assert(b->sort->id == SMT_SORT_INT || b->sort->id == SMT_SORT_REAL);
   assert(a->sort->id == b->sort->id);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_DIV);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_DIV);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1033,7 +1315,8 @@ smt_astt smtlib_convt::mk_bvsdiv(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVSDIV);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVSDIV);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1044,7 +1327,8 @@ smt_astt smtlib_convt::mk_bvudiv(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVUDIV);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVUDIV);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1055,7 +1339,7 @@ smt_astt smtlib_convt::mk_shl(smt_astt a, smt_astt b)
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
   assert(b->sort->id == SMT_SORT_INT || b->sort->id == SMT_SORT_REAL);
   assert(a->sort->id == b->sort->id);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_SHL);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_SHL);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1066,7 +1350,7 @@ smt_astt smtlib_convt::mk_bvshl(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVSHL);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVSHL);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1077,7 +1361,8 @@ smt_astt smtlib_convt::mk_bvashr(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVASHR);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVASHR);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1088,7 +1373,8 @@ smt_astt smtlib_convt::mk_bvlshr(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVLSHR);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVLSHR);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1097,7 +1383,7 @@ smt_astt smtlib_convt::mk_bvlshr(smt_astt a, smt_astt b)
 smt_astt smtlib_convt::mk_neg(smt_astt a)
 {
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_NEG);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_NEG);
   ast->args.push_back(a);
   return ast;
 }
@@ -1105,7 +1391,7 @@ smt_astt smtlib_convt::mk_neg(smt_astt a)
 smt_astt smtlib_convt::mk_bvneg(smt_astt a)
 {
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVNEG);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVNEG);
   ast->args.push_back(a);
   return ast;
 }
@@ -1113,7 +1399,7 @@ smt_astt smtlib_convt::mk_bvneg(smt_astt a)
 smt_astt smtlib_convt::mk_bvnot(smt_astt a)
 {
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVNOT);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVNOT);
   ast->args.push_back(a);
   return ast;
 }
@@ -1123,7 +1409,8 @@ smt_astt smtlib_convt::mk_bvnxor(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVNXOR);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVNXOR);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1134,7 +1421,7 @@ smt_astt smtlib_convt::mk_bvnor(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVNOR);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVNOR);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1145,7 +1432,8 @@ smt_astt smtlib_convt::mk_bvnand(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVNAND);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVNAND);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1156,7 +1444,7 @@ smt_astt smtlib_convt::mk_bvxor(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVXOR);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVXOR);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1167,7 +1455,7 @@ smt_astt smtlib_convt::mk_bvor(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVOR);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVOR);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1178,7 +1466,7 @@ smt_astt smtlib_convt::mk_bvand(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_BVAND);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_BVAND);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1188,7 +1476,7 @@ smt_astt smtlib_convt::mk_implies(smt_astt a, smt_astt b)
 {
   assert(a->sort->id == SMT_SORT_BOOL && b->sort->id == SMT_SORT_BOOL);
   smtlib_smt_ast *ast =
-    new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_IMPLIES);
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_IMPLIES);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1197,7 +1485,8 @@ smt_astt smtlib_convt::mk_implies(smt_astt a, smt_astt b)
 smt_astt smtlib_convt::mk_xor(smt_astt a, smt_astt b)
 {
   assert(a->sort->id == SMT_SORT_BOOL && b->sort->id == SMT_SORT_BOOL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_XOR);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_XOR);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1206,7 +1495,8 @@ smt_astt smtlib_convt::mk_xor(smt_astt a, smt_astt b)
 smt_astt smtlib_convt::mk_or(smt_astt a, smt_astt b)
 {
   assert(a->sort->id == SMT_SORT_BOOL && b->sort->id == SMT_SORT_BOOL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_OR);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_OR);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1215,7 +1505,8 @@ smt_astt smtlib_convt::mk_or(smt_astt a, smt_astt b)
 smt_astt smtlib_convt::mk_and(smt_astt a, smt_astt b)
 {
   assert(a->sort->id == SMT_SORT_BOOL && b->sort->id == SMT_SORT_BOOL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_AND);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_AND);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1224,7 +1515,8 @@ smt_astt smtlib_convt::mk_and(smt_astt a, smt_astt b)
 smt_astt smtlib_convt::mk_not(smt_astt a)
 {
   assert(a->sort->id == SMT_SORT_BOOL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_NOT);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_NOT);
   ast->args.push_back(a);
   return ast;
 }
@@ -1233,7 +1525,8 @@ smt_astt smtlib_convt::mk_lt(smt_astt a, smt_astt b)
 {
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
   assert(b->sort->id == SMT_SORT_INT || b->sort->id == SMT_SORT_REAL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_LT);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_LT);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1244,7 +1537,8 @@ smt_astt smtlib_convt::mk_bvult(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVULT);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVULT);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1255,7 +1549,8 @@ smt_astt smtlib_convt::mk_bvslt(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVSLT);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVSLT);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1265,7 +1560,8 @@ smt_astt smtlib_convt::mk_gt(smt_astt a, smt_astt b)
 {
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
   assert(b->sort->id == SMT_SORT_INT || b->sort->id == SMT_SORT_REAL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_GT);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_GT);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1276,7 +1572,8 @@ smt_astt smtlib_convt::mk_bvugt(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVUGT);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVUGT);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1287,7 +1584,8 @@ smt_astt smtlib_convt::mk_bvsgt(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVUGT);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVUGT);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1297,7 +1595,8 @@ smt_astt smtlib_convt::mk_le(smt_astt a, smt_astt b)
 {
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
   assert(b->sort->id == SMT_SORT_INT || b->sort->id == SMT_SORT_REAL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_LTE);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_LTE);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1308,7 +1607,8 @@ smt_astt smtlib_convt::mk_bvule(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVULTE);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVULTE);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1319,7 +1619,8 @@ smt_astt smtlib_convt::mk_bvsle(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVSLTE);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVSLTE);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1329,7 +1630,8 @@ smt_astt smtlib_convt::mk_ge(smt_astt a, smt_astt b)
 {
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
   assert(b->sort->id == SMT_SORT_INT || b->sort->id == SMT_SORT_REAL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_GTE);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_GTE);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1340,7 +1642,8 @@ smt_astt smtlib_convt::mk_bvuge(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVUGTE);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVUGTE);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1351,7 +1654,8 @@ smt_astt smtlib_convt::mk_bvsge(smt_astt a, smt_astt b)
   assert(a->sort->id != SMT_SORT_INT && a->sort->id != SMT_SORT_REAL);
   assert(b->sort->id != SMT_SORT_INT && b->sort->id != SMT_SORT_REAL);
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVSGTE);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_BVSGTE);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1360,7 +1664,8 @@ smt_astt smtlib_convt::mk_bvsge(smt_astt a, smt_astt b)
 smt_astt smtlib_convt::mk_eq(smt_astt a, smt_astt b)
 {
   assert(a->sort->get_data_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_EQ);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_EQ);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1372,7 +1677,7 @@ smt_astt smtlib_convt::mk_store(smt_astt a, smt_astt b, smt_astt c)
   assert(a->sort->get_domain_width() == b->sort->get_data_width());
   assert(
     a->sort->get_range_sort()->get_data_width() == c->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_STORE);
+  smtlib_smt_ast *ast = new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_STORE);
   ast->args.push_back(a);
   ast->args.push_back(b);
   ast->args.push_back(c);
@@ -1383,7 +1688,8 @@ smt_astt smtlib_convt::mk_select(smt_astt a, smt_astt b)
 {
   assert(a->sort->id == SMT_SORT_ARRAY);
   assert(a->sort->get_domain_width() == b->sort->get_data_width());
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, b->sort, SMT_FUNC_SELECT);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, b->sort, SMT_FUNC_SELECT);
   ast->args.push_back(a);
   ast->args.push_back(b);
   return ast;
@@ -1392,7 +1698,8 @@ smt_astt smtlib_convt::mk_select(smt_astt a, smt_astt b)
 smt_astt smtlib_convt::mk_real2int(smt_astt a)
 {
   assert(a->sort->id == SMT_SORT_REAL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_REAL2INT);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_REAL2INT);
   ast->args.push_back(a);
   return ast;
 }
@@ -1400,7 +1707,8 @@ smt_astt smtlib_convt::mk_real2int(smt_astt a)
 smt_astt smtlib_convt::mk_int2real(smt_astt a)
 {
   assert(a->sort->id == SMT_SORT_INT);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, a->sort, SMT_FUNC_INT2REAL);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, a->sort, SMT_FUNC_INT2REAL);
   ast->args.push_back(a);
   return ast;
 }
@@ -1408,14 +1716,18 @@ smt_astt smtlib_convt::mk_int2real(smt_astt a)
 smt_astt smtlib_convt::mk_isint(smt_astt a)
 {
   assert(a->sort->id == SMT_SORT_INT || a->sort->id == SMT_SORT_REAL);
-  smtlib_smt_ast *ast = new smtlib_smt_ast(this, boolean_sort, SMT_FUNC_IS_INT);
+  smtlib_smt_ast *ast =
+    new(this) smtlib_smt_ast(this, boolean_sort, SMT_FUNC_IS_INT);
   ast->args.push_back(a);
   return ast;
 }
 
 void smtlib_convt::pop_ctx()
 {
-  fprintf(out_stream, "(pop 1)\n");
+  emit("(pop 1)\n");
+
+  // The solver forgets the definitions made at this level
+  defined_terms.pop(ctx_level - 1);
 
   // Wipe this level of symbol table.
   symbol_tablet::nth_index<1>::type &syms_numindex = symbol_table.get<1>();
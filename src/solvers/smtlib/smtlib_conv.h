@@ -1,9 +1,14 @@
 #ifndef _ESBMC_SOLVERS_SMTLIB_SMTLIB_CONV_H
 #define _ESBMC_SOLVERS_SMTLIB_SMTLIB_CONV_H
 
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index_container.hpp>
 #include <list>
 #include <solvers/smt/smt_conv.h>
 #include <string>
+#include <unordered_map>
 #ifndef _WIN32
 #include <unistd.h>
 #endif
@@ -177,6 +182,10 @@ public:
   smtlib_convt(bool int_encoding, const namespacet &_ns);
   ~smtlib_convt() override;
 
+  /** Close this process' copies of the pipes to the idle solver processes,
+   *  without reusing them: in a forked child, they belong to the parent. */
+  static void forget_idle_solvers();
+
   resultt dec_solve() override;
   const std::string solver_text() override;
 
@@ -260,13 +269,36 @@ public:
   convert_array_of(smt_astt init_val, unsigned long domain_width) override;
 
   bool get_bool(smt_astt a) override;
+  void dump_smt() override;
   BigInt get_bv(smt_astt a, bool is_signed) override;
   expr2tc
   get_array_elem(smt_astt array, uint64_t index, const type2tc &type) override;
 
   std::string sort_to_string(const smt_sort *s) const;
   unsigned int emit_terminal_ast(const smtlib_smt_ast *a, std::string &output);
-  unsigned int emit_ast(const smtlib_smt_ast *ast, std::string &output);
+  /** Emit the subterms of ast that need it, and set output to the text
+   *  standing for ast. Subterms are bound by lets, or if define is set, by
+   *  define-funs that later terms can refer to.
+   *  @return The number of closing braces owed to the lets */
+  unsigned int
+  emit_ast(const smtlib_smt_ast *ast, std::string &output, bool define);
+  /** Emit a as a nest of lets, each subterm bound once, followed by the name
+   *  of the result. @return The number of closing braces owed */
+  unsigned int emit_term(smt_astt a);
+
+  /** Append printf-style formatted text to the output buffer */
+  void emit(const char *fmt, ...);
+  /** Start a zstd process writing to filename
+   *  @return The stream to write the uncompressed text to */
+  FILE *open_compressed_output(const std::string &filename);
+  /** Write out the output buffer */
+  void write_output();
+  /** Write out the output buffer and flush the stream, before waiting for
+   *  the solver or returning */
+  void flush_output();
+  /** Read the solver's response to a get-value of a single term
+   *  @return The text of the value */
+  std::string get_value_response();
 
   void push_ctx() override;
   void pop_ctx() override;
@@ -276,6 +308,38 @@ public:
   FILE *in_stream;
   std::string solver_name;
   std::string solver_version;
+  // Solver command, to find this process again when it's reused
+  std::string solver_cmd;
+
+  // Text waiting to be written to out_stream
+  std::string out_buf;
+  static const size_t out_buf_limit = 1 << 20;
+
+  // Compressing the output file, if any
+#ifndef _WIN32
+  pid_t compressor_pid;
+#else
+  int compressor_pid;
+#endif
+
+  // Temporary symbols bound by lets in the term currently being emitted
+  std::unordered_map<smt_astt, std::string> let_names;
+
+  // Temporary symbols defined as the value of a term
+  class smtlib_defined_termt
+  {
+  public:
+    smt_astt ast;
+    std::string name;
+    unsigned int ctx_level;
+  };
+
+  smt_level_cachet<
+    smtlib_defined_termt,
+    smt_astt,
+    &smtlib_defined_termt::ast,
+    std::hash<smt_astt>>
+    defined_terms;
 
   // Actual solving data
   // The set of symbols and their sorts.
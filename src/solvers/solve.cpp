@@ -5,6 +5,7 @@
 #include <solvers/smt/smt_array.h>
 #include <solvers/smt/tuple/smt_tuple_node.h>
 #include <solvers/smt/tuple/smt_tuple_sym.h>
+#include <solvers/smtlib/smtlib_conv.h>
 
 solver_creator create_new_smtlib_solver;
 solver_creator create_new_z3_solver;
@@ -189,3 +190,8 @@ smt_convt *create_solver_factory(
   ctx->smt_post_init();
   return ctx;
 }
+
+void solvers_forked_child()
+{
+  smtlib_convt::forget_idle_solvers();
+}
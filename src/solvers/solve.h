@@ -35,4 +35,8 @@ smt_convt *create_solver_factory(
   const namespacet &ns,
   const optionst &options);
 
+/** To be called in a child process after fork: forgets the solver processes
+ *  kept for reuse, which belong to the parent. */
+void solvers_forked_child();
+
 #endif
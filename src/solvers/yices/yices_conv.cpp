@@ -97,6 +97,25 @@ smt_convt::resultt yices_convt::dec_solve()
   return smt_convt::P_ERROR;
 }
 
+smt_convt::resultt yices_convt::dec_solve_assuming(const ast_vec &assumptions)
+{
+  pre_solve();
+
+  std::vector<term_t> terms;
+  for(smt_astt a : assumptions)
+    terms.push_back(to_solver_smt_ast<yices_smt_ast>(a)->a);
+
+  smt_status_t result = yices_check_context_with_assumptions(
+    yices_ctx, nullptr, terms.size(), terms.data());
+  if(result == STATUS_SAT)
+    return smt_convt::P_SATISFIABLE;
+
+  if(result == STATUS_UNSAT)
+    return smt_convt::P_UNSATISFIABLE;
+
+  return smt_convt::P_ERROR;
+}
+
 const std::string yices_convt::solver_text()
 {
   std::stringstream ss;
@@ -1010,7 +1029,7 @@ smt_astt yices_convt::mk_tuple_symbol(const std::string &name, smt_sortt s)
 smt_astt yices_convt::mk_tuple_array_symbol(const expr2tc &expr)
 {
   const symbol2t &sym = to_symbol2t(expr);
-  return mk_smt_symbol(sym.get_symbol_name(), convert_sort(sym.type));
+  return mk_smt_symbol(get_symbol_name(sym), convert_sort(sym.type));
 }
 
 expr2tc yices_convt::tuple_get(const expr2tc &expr)
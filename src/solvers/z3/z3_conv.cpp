@@ -94,6 +94,26 @@ smt_convt::resultt z3_convt::dec_solve()
   return smt_convt::P_ERROR;
 }
 
+smt_convt::resultt z3_convt::dec_solve_assuming(const ast_vec &assumptions)
+{
+  // Z3 only takes propositional symbols as assumptions
+  z3::expr_vector lits(z3_ctx);
+  for(smt_astt a : assumptions)
+    lits.push_back(to_solver_smt_ast<z3_smt_ast>(mk_assumption_literal(a))->a);
+
+  pre_solve();
+
+  z3::check_result result = solver.check(lits);
+
+  if(result == z3::sat)
+    return P_SATISFIABLE;
+
+  if(result == z3::unsat)
+    return smt_convt::P_UNSATISFIABLE;
+
+  return smt_convt::P_ERROR;
+}
+
 void z3_convt::assert_ast(smt_astt a)
 {
   z3::expr theval = to_solver_smt_ast<z3_smt_ast>(a)->a;
@@ -1088,7 +1108,7 @@ smt_astt z3_convt::mk_tuple_symbol(const std::string &name, smt_sortt s)
 smt_astt z3_convt::mk_tuple_array_symbol(const expr2tc &expr)
 {
   const symbol2t &sym = to_symbol2t(expr);
-  return mk_smt_symbol(sym.get_symbol_name(), convert_sort(sym.type));
+  return mk_smt_symbol(get_symbol_name(sym), convert_sort(sym.type));
 }
 
 smt_astt
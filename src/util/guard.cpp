@@ -7,20 +7,115 @@ Author: Daniel Kroening, kroening@kroening.com
 \*******************************************************************/
 
 #include <algorithm>
+#include <boost/functional/hash.hpp>
+#include <unordered_map>
 #include <util/guard.h>
 #include <util/irep2_utils.h>
 #include <util/std_expr.h>
 
+// Hash-consing table for guard nodes. It only holds weak references: a node
+// lives as long as some guard, or one of its children, refers to it.
+typedef std::unordered_multimap<size_t, std::weak_ptr<const guard_nodet>>
+  guard_poolt;
+static guard_poolt guard_pool;
+static size_t guard_pool_sweep_at = 1024;
+
+static inline unsigned int depth_of(const guard_nodet *n)
+{
+  return n ? n->depth : 0;
+}
+
+guard_nodet::ptrt
+guard_nodet::get(const guard_nodet::ptrt &parent, const expr2tc &literal)
+{
+  size_t hash = literal.crc();
+  boost::hash_combine(hash, parent.get());
+
+  auto range = guard_pool.equal_range(hash);
+  for(auto it = range.first; it != range.second; ++it)
+  {
+    ptrt n = it->second.lock();
+    if(n && n->parent == parent && n->literal == literal)
+      return n;
+  }
+
+  auto n = std::make_shared<guard_nodet>();
+  n->parent = parent;
+  n->literal = literal;
+  n->depth = depth_of(parent.get()) + 1;
+  n->expr = parent ? and2tc(parent->expr, literal) : literal;
+
+  // Skew-binary jumps: the jump target's depth only depends on this depth
+  if(parent)
+  {
+    const guard_nodet *j = parent->jump.get();
+    const guard_nodet *jj = j ? j->jump.get() : nullptr;
+    if(
+      j && parent->depth - depth_of(j) == depth_of(j) - depth_of(jj))
+      n->jump = j->jump;
+    else
+      n->jump = parent;
+  }
+
+  guard_pool.emplace(hash, n);
+  if(guard_pool.size() >= guard_pool_sweep_at)
+  {
+    for(auto it = guard_pool.begin(); it != guard_pool.end();)
+    {
+      if(it->second.expired())
+        it = guard_pool.erase(it);
+      else
+        ++it;
+    }
+    guard_pool_sweep_at = std::max<size_t>(1024, guard_pool.size() * 2);
+  }
+
+  return n;
+}
+
+static const guard_nodet *ancestor_at(const guard_nodet *n, unsigned int depth)
+{
+  while(depth_of(n) > depth)
+  {
+    if(depth_of(n->jump.get()) >= depth)
+      n = n->jump.get();
+    else
+      n = n->parent.get();
+  }
+
+  return n;
+}
+
+// Longest common prefix of two guards
+static const guard_nodet *
+common_ancestor(const guard_nodet *a, const guard_nodet *b)
+{
+  a = ancestor_at(a, depth_of(b));
+  b = ancestor_at(b, depth_of(a));
+
+  while(a != b)
+  {
+    if(a->jump != b->jump)
+    {
+      a = a->jump.get();
+      b = b->jump.get();
+    }
+    else
+    {
+      a = a->parent.get();
+      b = b->parent.get();
+    }
+  }
+
+  return a;
+}
+
 expr2tc guardt::as_expr() const
 {
   if(is_true())
     return gen_true_expr();
 
-  if(is_single_symbol())
-    return *guard_list.begin();
-
-  assert(!is_nil_expr(g_expr));
-  return g_expr;
+  return node->expr;
 }
 
 void guardt::add(const expr2tc &expr)
@@ -40,21 +135,7 @@ void guardt::add(const expr2tc &expr)
     return;
   }
 
-  guard_list.push_back(expr);
-
-  // Update the chain of ands
-
-  // Easy case, there is no g_expr
-  if(is_nil_expr(g_expr))
-  {
-    g_expr = expr;
-  }
-  else
-  {
-    // Otherwise, just update the chain of ands
-    and2tc new_g_expr(g_expr, expr);
-    g_expr.swap(new_g_expr);
-  }
+  node = guard_nodet::get(node, expr);
 }
 
 void guardt::guard_expr(expr2tc &dest) const
@@ -73,54 +154,44 @@ void guardt::guard_expr(expr2tc &dest) const
   dest = expr2tc(new implies2t(as_expr(), dest));
 }
 
-void guardt::build_guard_expr()
+void guardt::get_literals(guard_listt &dest, const guard_nodet *ancestor) const
 {
-  // This method closely related to guardt::add and guardt::guard_expr
-  // We need to build the chain of ands, to avoid memory bloat on as_expr
-
-  // if the guard is true, or a single symbol, we don't need to build it
-  if(is_true() || is_single_symbol())
-    return;
-
-  // This method will only be used, when the guard is nil, for instance,
-  // guardt &operator -= and guardt &operator |=, all other cases should
-  // be handled by guardt::add
-  assert(is_nil_expr(g_expr));
+  size_t start = dest.size();
+  for(const guard_nodet *n = node.get(); n != ancestor; n = n->parent.get())
+    dest.push_back(n->literal);
 
-  // We can assume at least two operands
-  auto it = guard_list.begin();
-
-  expr2tc arg1, arg2;
-  arg1 = *it++;
-  arg2 = *it++;
-  and2tc res(arg1, arg2);
-  while(it != guard_list.end())
-    res = and2tc(res, *it++);
+  std::reverse(dest.begin() + start, dest.end());
+}
 
-  g_expr.swap(res);
+void guardt::add_literals(const guard_listt &literals)
+{
+  for(auto const &it : literals)
+    add(it);
 }
 
 void guardt::append(const guardt &guard)
 {
-  for(auto const &it : guard.guard_list)
-    add(it);
+  guard_listt literals;
+  guard.get_literals(literals);
+  add_literals(literals);
 }
 
 guardt &operator-=(guardt &g1, const guardt &g2)
 {
+  // The common prefix goes; so does anything else g2 has
+  const guard_nodet *common = common_ancestor(g1.node.get(), g2.node.get());
+
+  guardt::guard_listt suffix1, suffix2;
+  g1.get_literals(suffix1, common);
+  g2.get_literals(suffix2, common);
+
   guardt::guard_listt diff;
-  std::set_difference(
-    g1.guard_list.begin(),
-    g1.guard_list.end(),
-    g2.guard_list.begin(),
-    g2.guard_list.end(),
-    std::back_inserter(diff));
-
-  // Clear g1 and build the guard's list and expr
-  g1.clear();
+  for(auto const &it : suffix1)
+    if(std::find(suffix2.begin(), suffix2.end(), it) == suffix2.end())
+      diff.push_back(it);
 
-  g1.guard_list.swap(diff);
-  g1.build_guard_expr();
+  g1.clear();
+  g1.add_literals(diff);
 
   return g1;
 }
@@ -140,7 +211,7 @@ guardt &operator|=(guardt &g1, const guardt &g2)
   {
     // Both guards have one symbol, so check if we opposite symbols, e.g,
     // g1 == sym1 and g2 == !sym1
-    expr2tc or_expr(new or2t(*g1.guard_list.begin(), *g2.guard_list.begin()));
+    expr2tc or_expr(new or2t(g1.node->literal, g2.node->literal));
     simplify(or_expr);
 
     if(::is_true(or_expr))
@@ -160,37 +231,28 @@ guardt &operator|=(guardt &g1, const guardt &g2)
     // g2 = guard2 && !guard1
     // res = g1 || g2 = (!guard3 && !guard2 && !guard1) || (guard2 && !guard1)
 
-    // Simplify equation: everything that's common in both guards, will not
-    // be or'd
+    // Simplify equation: the common prefix of both guards will not be or'd
+    const guard_nodet *common = common_ancestor(g1.node.get(), g2.node.get());
 
-    // Common guards
-    guardt common;
-    std::set_intersection(
-      g1.guard_list.begin(),
-      g1.guard_list.end(),
-      g2.guard_list.begin(),
-      g2.guard_list.end(),
-      std::back_inserter(common.guard_list));
-    common.build_guard_expr();
+    // If one guard is a prefix of the other, the disjunction is the prefix
+    if(common == g1.node.get())
+      return g1;
+    if(common == g2.node.get())
+    {
+      g1 = g2;
+      return g1;
+    }
 
     // New g1 and g2, without the common guards
+    guardt::guard_listt suffix;
     guardt new_g1;
-    std::set_difference(
-      g1.guard_list.begin(),
-      g1.guard_list.end(),
-      common.guard_list.begin(),
-      common.guard_list.end(),
-      std::back_inserter(new_g1.guard_list));
-    new_g1.build_guard_expr();
+    g1.get_literals(suffix, common);
+    new_g1.add_literals(suffix);
 
+    suffix.clear();
     guardt new_g2;
-    std::set_difference(
-      g2.guard_list.begin(),
-      g2.guard_list.end(),
-      common.guard_list.begin(),
-      common.guard_list.end(),
-      std::back_inserter(new_g2.guard_list));
-    new_g2.build_guard_expr();
+    g2.get_literals(suffix, common);
+    new_g2.add_literals(suffix);
 
     // Get the and expression from both guards
     expr2tc or_expr(new or2t(new_g1.as_expr(), new_g2.as_expr()));
@@ -199,7 +261,14 @@ guardt &operator|=(guardt &g1, const guardt &g2)
     if(new_g1.is_single_symbol() && new_g2.is_single_symbol())
       simplify(or_expr);
 
-    g1.clear_append(common);
+    // Keep the common prefix node, so it stays shared with other guards
+    while(g1.node.get() != common)
+    {
+      if(depth_of(g1.node->jump.get()) >= depth_of(common))
+        g1.node = g1.node->jump;
+      else
+        g1.node = g1.node->parent;
+    }
     g1.add(or_expr);
   }
 
@@ -208,20 +277,21 @@ guardt &operator|=(guardt &g1, const guardt &g2)
 
 void guardt::dump() const
 {
-  for(auto const &it : guard_list)
+  guard_listt literals;
+  get_literals(literals);
+  for(auto const &it : literals)
     it->dump();
 }
 
 bool operator==(const guardt &g1, const guardt &g2)
 {
-  // Very simple: the guard list should be identical.
-  return g1.guard_list == g2.guard_list;
+  // Nodes are hash-consed, equal literal lists are the same node
+  return g1.node == g2.node;
 }
 
 void guardt::swap(guardt &g)
 {
-  guard_list.swap(g.guard_list);
-  g_expr.swap(g.g_expr);
+  node.swap(g.node);
 }
 
 bool guardt::disjunction_may_simplify(const guardt &other_guard) const
@@ -242,21 +312,21 @@ bool guardt::disjunction_may_simplify(const guardt &other_guard) const
 
 bool guardt::is_true() const
 {
-  return guard_list.empty();
+  return node == nullptr;
 }
 
 bool guardt::is_false() const
 {
   // Never false
-  if(guard_list.size() != 1)
+  if(!is_single_symbol())
     return false;
 
-  return (*guard_list.begin() == gen_false_expr());
+  return ::is_false(node->literal);
 }
 
 void guardt::make_true()
 {
-  guard_list.clear();
+  node.reset();
 }
 
 void guardt::make_false()
@@ -266,13 +336,12 @@ void guardt::make_false()
 
 bool guardt::is_single_symbol() const
 {
-  return (guard_list.size() == 1);
+  return node && node->depth == 1;
 }
 
 void guardt::clear()
 {
-  guard_list.clear();
-  g_expr.reset();
+  node.reset();
 }
 
 void guardt::clear_append(const guardt &guard)
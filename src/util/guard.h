@@ -10,10 +10,31 @@ Author: Daniel Kroening, kroening@kroening.com
 #define CPROVER_GUARD_H
 
 #include <iostream>
+#include <memory>
 #include <util/expr.h>
 #include <util/irep2.h>
 #include <util/migrate.h>
 
+/** Node of the guard tree: a guard is the conjunction of the literals on the
+ *  path from the root to its node. Nodes are hash-consed on (parent,
+ *  literal), so guards grown from a common prefix share it, and two guards
+ *  are equal iff they point at the same node. */
+class guard_nodet
+{
+public:
+  typedef std::shared_ptr<const guard_nodet> ptrt;
+
+  ptrt parent;
+  // Skew-binary jump pointer, for O(log n) ancestor queries
+  ptrt jump;
+  expr2tc literal;
+  // Conjunction of all the literals up to here, sharing the parent's one
+  expr2tc expr;
+  unsigned int depth;
+
+  static ptrt get(const ptrt &parent, const expr2tc &literal);
+};
+
 class guardt
 {
 public:
@@ -44,15 +65,18 @@ public:
   void dump() const;
 
 protected:
-  guard_listt guard_list;
-  expr2tc g_expr;
+  // nullptr is the true guard
+  guard_nodet::ptrt node;
 
   bool is_single_symbol() const;
   void clear();
   void clear_append(const guardt &guard);
   void clear_insert(const expr2tc &expr);
 
-  void build_guard_expr();
+  /** Literals of this guard from the root down, stopping at ancestor */
+  void
+  get_literals(guard_listt &dest, const guard_nodet *ancestor = nullptr) const;
+  void add_literals(const guard_listt &literals);
 };
 
 #endif
@@ -68,6 +68,13 @@ type2t::type2t(type_ids id)
 {
 }
 
+type2t::type2t(const type2t &ref)
+  : std::enable_shared_from_this<type2t>(),
+    type_id(ref.type_id),
+    crc_val(ref.crc_val.load())
+{
+}
+
 bool type2t::operator==(const type2t &ref) const
 {
   return cmpchecked(ref);
@@ -132,11 +139,13 @@ size_t type2t::crc() const
 
 size_t type2t::do_crc() const
 {
-  boost::hash_combine(this->crc_val, (uint8_t)type_id);
-  return this->crc_val;
+  size_t crc = this->crc_val;
+  boost::hash_combine(crc, (uint8_t)type_id);
+  this->crc_val = crc;
+  return crc;
 }
 
-void type2t::hash(crypto_hash &hash) const
+void type2t::hash(state_hashert &hash) const
 {
   static_assert(type2t::end_type_id < 256, "Type id overflow");
   uint8_t tid = type_id;
@@ -314,7 +323,7 @@ expr2t::expr2t(const expr2t &ref)
   : std::enable_shared_from_this<expr2t>(),
     expr_id(ref.expr_id),
     type(ref.type),
-    crc_val(ref.crc_val)
+    crc_val(ref.crc_val.load())
 {
 }
 
@@ -412,12 +421,14 @@ size_t expr2t::crc() const
 
 size_t expr2t::do_crc() const
 {
-  boost::hash_combine(this->crc_val, type->do_crc());
-  boost::hash_combine(this->crc_val, (uint8_t)expr_id);
-  return this->crc_val;
+  size_t crc = this->crc_val;
+  boost::hash_combine(crc, type->do_crc());
+  boost::hash_combine(crc, (uint8_t)expr_id);
+  this->crc_val = crc;
+  return crc;
 }
 
-void expr2t::hash(crypto_hash &hash) const
+void expr2t::hash(state_hashert &hash) const
 {
   static_assert(expr2t::end_expr_id < 256, "Expr id overflow");
   uint8_t eid = expr_id;
@@ -748,6 +759,7 @@ type_poolt &type_poolt::operator=(type_poolt const &ref)
   fixedbv_map = ref.fixedbv_map;
   floatbv_map = ref.floatbv_map;
   string_map = ref.string_map;
+  symbol_map = ref.symbol_map;
   code_map = ref.code_map;
 
   // Re-establish some pointers
@@ -763,23 +775,17 @@ type_poolt &type_poolt::operator=(type_poolt const &ref)
   return *this;
 }
 
-// XXX investigate performance implications of this cache
 static const type2tc &
-get_type_from_pool(const typet &val, std::map<typet, type2tc> &)
+get_type_from_pool(const typet &val, std::map<typet, type2tc> &map)
 {
-#if 0
-  std::map<const typet, type2tc>::const_iterator it = map.find(val);
-  if (it != map.end())
+  std::map<typet, type2tc>::const_iterator it = map.find(val);
+  if(it != map.end())
     return it->second;
-#endif
 
+  // Migration happens without a namespace, so the result only depends on val
   type2tc new_type;
   real_migrate_type(val, new_type);
-#if 0
-  map[val] = new_type;
-  return map[val];
-#endif
-  return *(new type2tc(new_type));
+  return map.emplace(val, new_type).first->second;
 }
 
 const type2tc &type_poolt::get_struct(const typet &val)
@@ -873,6 +879,84 @@ const type2tc &type_poolt::get_int(unsigned int size)
 
 type_poolt type_pool;
 
+expr_poolt::expr_poolt() : hits(0), misses(0), sweep_at(1024)
+{
+}
+
+void expr_poolt::intern(expr2tc &expr)
+{
+  if(is_nil_expr(expr))
+    return;
+
+  // Only look through a const reference, non-const access detaches
+  const expr2tc &cexpr = expr;
+  size_t crc = cexpr.crc();
+  auto range = pool.equal_range(crc);
+  for(auto it = range.first; it != range.second; ++it)
+  {
+    std::shared_ptr<expr2t> canon = it->second.lock();
+    if(!canon)
+      continue;
+
+    if(canon.get() == cexpr.get())
+      return;
+
+    if(*canon == *cexpr)
+    {
+      expr = expr2tc(std::move(canon));
+      hits++;
+      return;
+    }
+  }
+
+  // Not seen before: canonicalise the operands, only detaching this node
+  // (which may be shared) when one of them is actually replaced. Each
+  // operand is interned exactly once: interning them again through the
+  // detached node would redo the work below every replaced operand.
+  std::vector<expr2tc> ops;
+  bool changed = false;
+  cexpr->foreach_operand([this, &ops, &changed](const expr2tc &op) {
+    ops.push_back(op);
+    intern(ops.back());
+    const expr2tc &interned = ops.back();
+    changed |= interned.get() != op.get();
+  });
+
+  if(changed)
+  {
+    unsigned int i = 0;
+    expr.get()->Foreach_operand([&ops, &i](expr2tc &op) { op = ops[i++]; });
+    crc = cexpr.crc();
+  }
+
+  pool.emplace(crc, std::weak_ptr<expr2t>(expr));
+  misses++;
+
+  if(pool.size() >= sweep_at)
+    sweep();
+}
+
+void expr_poolt::clear()
+{
+  pool.clear();
+  sweep_at = 1024;
+}
+
+void expr_poolt::sweep()
+{
+  for(auto it = pool.begin(); it != pool.end();)
+  {
+    if(it->second.expired())
+      it = pool.erase(it);
+    else
+      ++it;
+  }
+
+  sweep_at = std::max<size_t>(1024, pool.size() * 2);
+}
+
+expr_poolt expr_pool;
+
 // For CRCing to actually be accurate, expr/type ids mustn't overflow out of
 // a byte. If this happens then a) there are too many exprs, and b) the expr
 // crcing code has to change.
@@ -1286,7 +1370,7 @@ static inline size_t do_type_crc(const bool &theval)
   return boost::hash<bool>()(theval);
 }
 
-static inline void do_type_hash(const bool &thebool, crypto_hash &hash)
+static inline void do_type_hash(const bool &thebool, state_hashert &hash)
 {
   if(thebool)
   {
@@ -1305,7 +1389,7 @@ static inline size_t do_type_crc(const unsigned int &theval)
   return boost::hash<unsigned int>()(theval);
 }
 
-static inline void do_type_hash(const unsigned int &theval, crypto_hash &hash)
+static inline void do_type_hash(const unsigned int &theval, state_hashert &hash)
 {
   hash.ingest((void *)&theval, sizeof(theval));
 }
@@ -1316,7 +1400,7 @@ static inline size_t do_type_crc(const sideeffect_data::allockind &theval)
 }
 
 static inline void
-do_type_hash(const sideeffect_data::allockind &theval, crypto_hash &hash)
+do_type_hash(const sideeffect_data::allockind &theval, state_hashert &hash)
 {
   hash.ingest((void *)&theval, sizeof(theval));
 }
@@ -1327,7 +1411,7 @@ static inline size_t do_type_crc(const symbol_data::renaming_level &theval)
 }
 
 static inline void
-do_type_hash(const symbol_data::renaming_level &theval, crypto_hash &hash)
+do_type_hash(const symbol_data::renaming_level &theval, state_hashert &hash)
 {
   hash.ingest((void *)&theval, sizeof(theval));
 }
@@ -1354,7 +1438,7 @@ static inline size_t do_type_crc(const BigInt &theint)
   return crc;
 }
 
-static inline void do_type_hash(const BigInt &theint, crypto_hash &hash)
+static inline void do_type_hash(const BigInt &theint, state_hashert &hash)
 {
   // Zero has no data in bigints.
   if(theint.is_zero())
@@ -1383,7 +1467,7 @@ static inline size_t do_type_crc(const fixedbvt &theval)
   return do_type_crc(BigInt(theval.to_ansi_c_string().c_str()));
 }
 
-static inline void do_type_hash(const fixedbvt &theval, crypto_hash &hash)
+static inline void do_type_hash(const fixedbvt &theval, state_hashert &hash)
 {
   do_type_hash(BigInt(theval.to_ansi_c_string().c_str()), hash);
 }
@@ -1393,7 +1477,7 @@ static inline size_t do_type_crc(const ieee_floatt &theval)
   return do_type_crc(theval.pack());
 }
 
-static inline void do_type_hash(const ieee_floatt &theval, crypto_hash &hash)
+static inline void do_type_hash(const ieee_floatt &theval, state_hashert &hash)
 {
   do_type_hash(theval.pack(), hash);
 }
@@ -1408,7 +1492,7 @@ static inline size_t do_type_crc(const std::vector<expr2tc> &theval)
 }
 
 static inline void
-do_type_hash(const std::vector<expr2tc> &theval, crypto_hash &hash)
+do_type_hash(const std::vector<expr2tc> &theval, state_hashert &hash)
 {
   for(auto const &it : theval)
     it->hash(hash);
@@ -1424,7 +1508,7 @@ static inline size_t do_type_crc(const std::vector<type2tc> &theval)
 }
 
 static inline void
-do_type_hash(const std::vector<type2tc> &theval, crypto_hash &hash)
+do_type_hash(const std::vector<type2tc> &theval, state_hashert &hash)
 {
   for(auto const &it : theval)
     it->hash(hash);
@@ -1440,7 +1524,7 @@ static inline size_t do_type_crc(const std::vector<irep_idt> &theval)
 }
 
 static inline void
-do_type_hash(const std::vector<irep_idt> &theval, crypto_hash &hash)
+do_type_hash(const std::vector<irep_idt> &theval, state_hashert &hash)
 {
   for(auto const &it : theval)
     hash.ingest((void *)it.as_string().c_str(), it.as_string().size());
@@ -1453,7 +1537,7 @@ static inline size_t do_type_crc(const expr2tc &theval)
   return boost::hash<uint8_t>()(0);
 }
 
-static inline void do_type_hash(const expr2tc &theval, crypto_hash &hash)
+static inline void do_type_hash(const expr2tc &theval, state_hashert &hash)
 {
   if(theval.get() != nullptr)
     theval->hash(hash);
@@ -1466,7 +1550,7 @@ static inline size_t do_type_crc(const type2tc &theval)
   return boost::hash<uint8_t>()(0);
 }
 
-static inline void do_type_hash(const type2tc &theval, crypto_hash &hash)
+static inline void do_type_hash(const type2tc &theval, state_hashert &hash)
 {
   if(theval.get() != nullptr)
     theval->hash(hash);
@@ -1477,7 +1561,7 @@ static inline size_t do_type_crc(const irep_idt &theval)
   return boost::hash<std::string>()(theval.as_string());
 }
 
-static inline void do_type_hash(const irep_idt &theval, crypto_hash &hash)
+static inline void do_type_hash(const irep_idt &theval, state_hashert &hash)
 {
   hash.ingest((void *)theval.as_string().c_str(), theval.as_string().size());
 }
@@ -1487,7 +1571,7 @@ static inline size_t do_type_crc(const type2t::type_ids &i)
   return boost::hash<uint8_t>()(i);
 }
 
-static inline void do_type_hash(const type2t::type_ids &, crypto_hash &)
+static inline void do_type_hash(const type2t::type_ids &, state_hashert &)
 {
   // Dummy field crc
 }
@@ -1497,7 +1581,7 @@ static inline size_t do_type_crc(const expr2t::expr_ids &i)
   return boost::hash<uint8_t>()(i);
 }
 
-static inline void do_type_hash(const expr2t::expr_ids &, crypto_hash &)
+static inline void do_type_hash(const expr2t::expr_ids &, state_hashert &)
 {
   // Dummy field crc
 }
@@ -1917,17 +2001,17 @@ size_t
 esbmct::irep_methods2<derived, baseclass, traits, container, enable, fields>::
   do_crc() const
 {
-  if(this->crc_val != 0)
-    return this->crc_val;
+  size_t crc = this->crc_val;
+  if(crc != 0)
+    return crc;
 
   // Starting from 0, pass a crc value through all the sub-fields of this
-  // expression. Store it into crc_val.
-  assert(this->crc_val == 0);
+  // expression, and only then store it into crc_val: another thread may be
+  // reading it.
+  do_crc_rec(crc); // _includes_ type_id / expr_id
 
-  do_crc_rec(); // _includes_ type_id / expr_id
-
-  // Finally, combine the crc of this expr with the input , and return
-  return this->crc_val;
+  this->crc_val = crc;
+  return crc;
 }
 
 template <
@@ -1939,7 +2023,7 @@ template <
   typename fields>
 void esbmct::
   irep_methods2<derived, baseclass, traits, container, enable, fields>::hash(
-    crypto_hash &hash) const
+    state_hashert &hash) const
 {
   hash_rec(hash); // _includes_ type_id / expr_id
 }
@@ -2033,15 +2117,15 @@ template <
   typename fields>
 void esbmct::
   irep_methods2<derived, baseclass, traits, container, enable, fields>::
-    do_crc_rec() const
+    do_crc_rec(size_t &crc) const
 {
   const derived *derived_this = static_cast<const derived *>(this);
   auto m_ptr = membr_ptr::value;
 
   size_t tmp = do_type_crc(derived_this->*m_ptr);
-  boost::hash_combine(this->crc_val, tmp);
+  boost::hash_combine(crc, tmp);
 
-  superclass::do_crc_rec();
+  superclass::do_crc_rec(crc);
 }
 
 template <
@@ -2053,7 +2137,7 @@ template <
   typename fields>
 void esbmct::
   irep_methods2<derived, baseclass, traits, container, enable, fields>::
-    hash_rec(crypto_hash &hash) const
+    hash_rec(state_hashert &hash) const
 {
   const derived *derived_this = static_cast<const derived *>(this);
   auto m_ptr = membr_ptr::value;
@@ -5,6 +5,7 @@
  *  Classes and definitions for non-stringy internal representation.
  */
 
+#include <atomic>
 #include <big-int/bigint.hh>
 #include <boost/bind/placeholders.hpp>
 #include <boost/crc.hpp>
@@ -27,10 +28,11 @@
 #include <boost/preprocessor/list/for_each.hpp>
 #include <cstdarg>
 #include <functional>
+#include <memory>
 #include <util/config.h>
-#include <util/crypto_hash.h>
 #include <util/dstring.h>
 #include <util/irep.h>
+#include <util/state_hash.h>
 #include <vector>
 
 // Ahead of time: a list of all expressions and types, in a preprocessing
@@ -281,8 +283,9 @@ public:
   size_t crc() const
   {
     const T *foo = std::shared_ptr<T>::get();
-    if(foo->crc_val != 0)
-      return foo->crc_val;
+    size_t crc = foo->crc_val;
+    if(crc != 0)
+      return crc;
 
     return foo->do_crc();
   }
@@ -342,7 +345,7 @@ protected:
   type2t(type_ids id);
 
   /** Copy constructor */
-  type2t(const type2t &ref) = default;
+  type2t(const type2t &ref);
 
   virtual void foreach_subtype_impl_const(const_subtype_delegate &t) const = 0;
   virtual void foreach_subtype_impl(subtype_delegate &t) = 0;
@@ -463,7 +466,7 @@ public:
    *  @see do_crc
    *  @param hash Object to accumulate hash data into.
    */
-  virtual void hash(crypto_hash &hash) const;
+  virtual void hash(state_hashert &hash) const;
 
   /** Clone method. Self explanatory.
    *  @return New container, containing a duplicate of this object.
@@ -489,7 +492,9 @@ public:
   // XXX XXX XXX this should be const
   type_ids type_id;
 
-  mutable size_t crc_val;
+  /** Cached hash, or zero. Computed in full before being stored, so that
+   *  types can be hashed from several threads at once. */
+  mutable std::atomic<size_t> crc_val;
 };
 
 /** Fetch identifying name for a type.
@@ -665,7 +670,7 @@ public:
    *  @see do_crc
    *  @param hash Object to accumulate hash data into.
    */
-  virtual void hash(crypto_hash &hash) const;
+  virtual void hash(state_hashert &hash) const;
 
   /** Fetch a sub-operand.
    *  These can come out of any field that is an expr2tc, or contains them.
@@ -761,7 +766,9 @@ public:
   /** Type of this expr. All exprs have a type. */
   type2tc type;
 
-  mutable size_t crc_val;
+  /** Cached hash, or zero. Computed in full before being stored, so that
+   *  expressions can be hashed from several threads at once. */
+  mutable std::atomic<size_t> crc_val;
 };
 
 inline bool is_nil_expr(const expr2tc &exp)
@@ -1101,7 +1108,7 @@ public:
   bool cmp(const base2t &ref) const override;
   int lt(const base2t &ref) const override;
   size_t do_crc() const override;
-  void hash(crypto_hash &hash) const override;
+  void hash(state_hashert &hash) const override;
 
 protected:
   // Fetch the type information about the field we are concerned with out
@@ -1117,8 +1124,8 @@ protected:
     unsigned int indent) const;
   bool cmp_rec(const base2t &ref) const;
   int lt_rec(const base2t &ref) const;
-  void do_crc_rec() const;
-  void hash_rec(crypto_hash &hash) const;
+  void do_crc_rec(size_t &crc) const;
+  void hash_rec(state_hashert &hash) const;
 
   // These methods are specific to expressions rather than types, and are
   // placed here to avoid un-necessary recursion in expr_methods2.
@@ -1192,11 +1199,12 @@ protected:
     return 0;
   }
 
-  void do_crc_rec() const
+  void do_crc_rec(size_t &crc) const
   {
+    (void)crc;
   }
 
-  void hash_rec(crypto_hash &hash) const
+  void hash_rec(state_hashert &hash) const
   {
     (void)hash;
   }
@@ -1440,6 +1448,10 @@ T2 *get_pointer(esbmct::something2tc<T1, T2, T3, T4, T5, T6> const &p)
 
 inline bool operator==(const type2tc &a, const type2tc &b)
 {
+  // Pooled types are shared, so this is the common case
+  if(a.get() == b.get())
+    return true;
+
   // Handle nil ireps
   if(is_nil_type(a) && is_nil_type(b))
     return true;
@@ -1474,6 +1486,10 @@ inline bool operator>(const type2tc &a, const type2tc &b)
 
 inline bool operator==(const expr2tc &a, const expr2tc &b)
 {
+  // Interned expressions are shared, see expr_poolt
+  if(a.get() == b.get())
+    return true;
+
   if(is_nil_expr(a) && is_nil_expr(b))
     return true;
   if(is_nil_expr(a) || is_nil_expr(b))
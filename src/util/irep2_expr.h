@@ -4,6 +4,7 @@
 #include <util/fixedbv.h>
 #include <util/ieee_float.h>
 #include <util/irep2_type.h>
+#include <unordered_map>
 
 // So - make some type definitions for the different types we're going to be
 // working with. This is to avoid the repeated use of template names in later
@@ -3528,4 +3529,63 @@ BOOST_PP_LIST_FOR_EACH(_ESBMC_IREP2_MACROS_ENUM, foo, ESBMC_LIST_OF_EXPRS)
 #undef dynamic_cast
 #endif
 
+/** Pool of canonical expressions.
+ *  Interning an expression replaces it, and recursively its operands, by a
+ *  structurally equal node already in the pool (as decided by crc() and
+ *  operator==). Symex produces the same guards, renamed symbols and constants
+ *  over and over; keeping only one node for each of them shrinks memory and
+ *  lets later comparisons succeed on pointer equality. The pool only holds
+ *  weak references, so nodes nobody else uses are still freed; their entries
+ *  are swept out as the pool grows. */
+class expr_poolt
+{
+public:
+  expr_poolt();
+
+  void intern(expr2tc &expr);
+  void clear();
+
+  size_t size() const
+  {
+    return pool.size();
+  }
+
+  unsigned long hits;
+  unsigned long misses;
+
+protected:
+  void sweep();
+
+  typedef std::unordered_multimap<size_t, std::weak_ptr<expr2t>> poolt;
+  poolt pool;
+  size_t sweep_at;
+};
+
+extern expr_poolt expr_pool;
+
+/** Memo table for expr2t::simplify.
+ *  Each distinct expression is simplified once per run, including the most
+ *  common outcome, "nothing to simplify". Guards grown by guardt::add share
+ *  most of their terms, which would otherwise be re-simplified every time.
+ *  The table is flushed when it reaches capacity entries; a capacity of zero
+ *  disables it. */
+class simplify_cachet
+{
+public:
+  simplify_cachet();
+
+  bool lookup(const expr2tc &expr, expr2tc &res);
+  void insert(const expr2tc &expr, const expr2tc &res);
+  void set_capacity(size_t size);
+
+  size_t capacity;
+  unsigned long hits;
+  unsigned long misses;
+
+protected:
+  std::unordered_map<expr2tc, expr2tc, irep2_hash> cache;
+};
+
+extern simplify_cachet simplify_cache;
+
 #endif /* IREP2_EXPR_H_ */
@@ -1,6 +1,7 @@
 #ifndef UTIL_IREP2_UTILS_H_
 #define UTIL_IREP2_UTILS_H_
 
+#include <boost/functional/hash.hpp>
 #include <util/irep2_expr.h>
 #include <util/c_types.h>
 
@@ -407,4 +408,73 @@ inline expr2tc gen_one(const type2tc &type)
   abort();
 }
 
+/** Compact identity of an SSA symbol: two symbols have equal keys iff
+ *  symbol_data::get_symbol_name gives the same string for them, but the key
+ *  is built without allocating. Fields get_symbol_name ignores at the
+ *  symbol's renaming level are zeroed. */
+struct symbol_keyt
+{
+  explicit symbol_keyt(const symbol2t &sym)
+    : name(sym.thename.get_no()),
+      level1_num(0),
+      thread_num(0),
+      node_num(0),
+      level2_num(0)
+  {
+    switch(sym.rlevel)
+    {
+    case symbol2t::level0:
+    case symbol2t::level1_global:
+      level = 0;
+      break;
+    case symbol2t::level1:
+      level = 1;
+      level1_num = sym.level1_num;
+      thread_num = sym.thread_num;
+      break;
+    case symbol2t::level2:
+      level = 2;
+      level1_num = sym.level1_num;
+      thread_num = sym.thread_num;
+      node_num = sym.node_num;
+      level2_num = sym.level2_num;
+      break;
+    case symbol2t::level2_global:
+      level = 3;
+      node_num = sym.node_num;
+      level2_num = sym.level2_num;
+      break;
+    }
+  }
+
+  bool operator==(const symbol_keyt &ref) const
+  {
+    return name == ref.name && level == ref.level &&
+           level1_num == ref.level1_num && thread_num == ref.thread_num &&
+           node_num == ref.node_num && level2_num == ref.level2_num;
+  }
+
+  unsigned int name;
+  unsigned int level;
+  unsigned int level1_num;
+  unsigned int thread_num;
+  unsigned int node_num;
+  unsigned int level2_num;
+};
+
+struct symbol_key_hash
+{
+  size_t operator()(const symbol_keyt &ref) const
+  {
+    size_t seed = 0;
+    boost::hash_combine(seed, ref.name);
+    boost::hash_combine(seed, ref.level);
+    boost::hash_combine(seed, ref.level1_num);
+    boost::hash_combine(seed, ref.thread_num);
+    boost::hash_combine(seed, ref.node_num);
+    boost::hash_combine(seed, ref.level2_num);
+    return seed;
+  }
+};
+
 #endif /* UTIL_IREP2_UTILS_H_ */
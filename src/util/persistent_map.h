@@ -0,0 +1,450 @@
+#ifndef UTIL_PERSISTENT_MAP_H_
+#define UTIL_PERSISTENT_MAP_H_
+
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/** Hash map with structural sharing, implemented as a hash array mapped trie.
+ *
+ *  Copying a persistent_mapt is O(1): both copies share all of their nodes,
+ *  and a node is only duplicated, together with the path leading to it, when
+ *  one of the copies modifies it. This makes it cheap to keep many snapshots
+ *  of a large map that only differ in a few entries, which is what symex does
+ *  with the states it saves at each goto.
+ *
+ *  The interface is the subset of std::unordered_map that its users need,
+ *  except that lookups and iteration are always read-only: find_mutable and
+ *  begin_mutable have to be asked for explicitly, as they unshare nodes.
+ *  Any modification invalidates iterators. */
+template <
+  class Key,
+  class T,
+  class Hash = std::hash<Key>,
+  class KeyEqual = std::equal_to<Key>>
+class persistent_mapt
+{
+public:
+  typedef Key key_type;
+  typedef T mapped_type;
+  typedef std::pair<Key, T> value_type;
+
+protected:
+  static const unsigned int bits = 5;
+  static const size_t slot_mask = (1 << bits) - 1;
+
+  struct nodet;
+  struct leaft;
+  typedef std::shared_ptr<nodet> node_ptrt;
+  typedef std::shared_ptr<leaft> leaf_ptrt;
+
+  /** Entries whose hashes are all equal */
+  struct leaft
+  {
+    size_t hash;
+    std::vector<value_type> entries;
+  };
+
+  /** Either a sub-trie or a leaf */
+  struct slott
+  {
+    node_ptrt child;
+    leaf_ptrt leaf;
+  };
+
+  struct nodet
+  {
+    uint32_t bitmap = 0;
+    std::vector<slott> slots;
+
+    unsigned int index(unsigned int bit) const
+    {
+      return __builtin_popcount(bitmap & ((1u << bit) - 1));
+    }
+  };
+
+  template <bool is_const>
+  class iterator_baset
+  {
+  public:
+    typedef typename std::
+      conditional<is_const, const value_type, value_type>::type entryt;
+
+    iterator_baset() : entry(0)
+    {
+    }
+
+    // Mutable iterators convert to const ones
+    template <bool other_const>
+    iterator_baset(
+      const iterator_baset<other_const> &ref,
+      typename std::enable_if<is_const && !other_const>::type * = nullptr)
+      : stack(ref.stack), entry(ref.entry)
+    {
+    }
+
+    entryt &operator*() const
+    {
+      return leaf()->entries[entry];
+    }
+
+    entryt *operator->() const
+    {
+      return &leaf()->entries[entry];
+    }
+
+    iterator_baset &operator++()
+    {
+      if(++entry < leaf()->entries.size())
+        return *this;
+
+      entry = 0;
+      next_slot();
+      return *this;
+    }
+
+    bool operator==(const iterator_baset &ref) const
+    {
+      if(stack.empty() || ref.stack.empty())
+        return stack.empty() && ref.stack.empty();
+
+      return stack.back() == ref.stack.back() && entry == ref.entry;
+    }
+
+    bool operator!=(const iterator_baset &ref) const
+    {
+      return !(*this == ref);
+    }
+
+  protected:
+    friend class persistent_mapt;
+    template <bool>
+    friend class iterator_baset;
+
+    leaft *leaf() const
+    {
+      const auto &top = stack.back();
+      return top.first->slots[top.second].leaf.get();
+    }
+
+    // Walk down to the first leaf below the current slot
+    void descend()
+    {
+      for(;;)
+      {
+        const auto &top = stack.back();
+        nodet *child = top.first->slots[top.second].child.get();
+        if(!child)
+          return;
+        stack.emplace_back(child, 0);
+      }
+    }
+
+    void next_slot()
+    {
+      while(!stack.empty())
+      {
+        auto &top = stack.back();
+        if(++top.second < top.first->slots.size())
+        {
+          descend();
+          return;
+        }
+        stack.pop_back();
+      }
+    }
+
+    std::vector<std::pair<nodet *, unsigned int>> stack;
+    unsigned int entry;
+  };
+
+public:
+  typedef iterator_baset<false> iterator;
+  typedef iterator_baset<true> const_iterator;
+
+  persistent_mapt() : root(std::make_shared<nodet>()), num_elems(0)
+  {
+  }
+
+  size_t size() const
+  {
+    return num_elems;
+  }
+
+  bool empty() const
+  {
+    return num_elems == 0;
+  }
+
+  void clear()
+  {
+    root = std::make_shared<nodet>();
+    num_elems = 0;
+  }
+
+  /** True if the two maps are copies of each other that neither has
+   *  modified since, so that they're certainly equal */
+  bool shares_root(const persistent_mapt &ref) const
+  {
+    return root == ref.root;
+  }
+
+  const_iterator begin() const
+  {
+    const_iterator it;
+    if(!root->slots.empty())
+    {
+      it.stack.emplace_back(root.get(), 0);
+      it.descend();
+    }
+    return it;
+  }
+
+  const_iterator end() const
+  {
+    return const_iterator();
+  }
+
+  /** Iterate with write access: this unshares every node of the map */
+  iterator begin_mutable()
+  {
+    unshare_all(root);
+    iterator it;
+    if(!root->slots.empty())
+    {
+      it.stack.emplace_back(root.get(), 0);
+      it.descend();
+    }
+    return it;
+  }
+
+  iterator end_mutable()
+  {
+    return iterator();
+  }
+
+  const_iterator find(const Key &key) const
+  {
+    const_iterator it;
+    lookup(key, false, it);
+    return it;
+  }
+
+  /** Look up key for writing: unshares the path to it if it's present */
+  iterator find_mutable(const Key &key)
+  {
+    iterator it;
+    if(lookup(key, false, it))
+      lookup(key, true, it);
+    return it;
+  }
+
+  size_t count(const Key &key) const
+  {
+    const_iterator it;
+    return lookup(key, false, it) ? 1 : 0;
+  }
+
+  std::pair<iterator, bool> insert(const value_type &value)
+  {
+    size_t hash = Hash()(value.first);
+    iterator it;
+    node_ptrt *node = &root;
+    size_t shift = 0;
+
+    for(;;)
+    {
+      unshare(*node);
+      nodet &n = **node;
+      unsigned int bit = (hash >> shift) & slot_mask;
+      unsigned int idx = n.index(bit);
+      it.stack.emplace_back(&n, idx);
+
+      if(!(n.bitmap & (1u << bit)))
+      {
+        slott s;
+        s.leaf = std::make_shared<leaft>();
+        s.leaf->hash = hash;
+        s.leaf->entries.push_back(value);
+        n.slots.insert(n.slots.begin() + idx, s);
+        n.bitmap |= 1u << bit;
+        num_elems++;
+        return std::make_pair(it, true);
+      }
+
+      slott &s = n.slots[idx];
+      if(s.child)
+      {
+        node = &s.child;
+        shift += bits;
+        continue;
+      }
+
+      if(s.leaf->hash == hash)
+      {
+        unshare(s.leaf);
+        std::vector<value_type> &entries = s.leaf->entries;
+        for(unsigned int i = 0; i < entries.size(); i++)
+        {
+          if(KeyEqual()(entries[i].first, value.first))
+          {
+            it.entry = i;
+            return std::make_pair(it, false);
+          }
+        }
+
+        it.entry = entries.size();
+        entries.push_back(value);
+        num_elems++;
+        return std::make_pair(it, true);
+      }
+
+      // Two different hashes in one slot: push the existing leaf one level
+      // down, and carry on inserting there.
+      it.stack.pop_back();
+      node_ptrt child = std::make_shared<nodet>();
+      unsigned int oldbit = (s.leaf->hash >> (shift + bits)) & slot_mask;
+      child->bitmap = 1u << oldbit;
+      child->slots.emplace_back();
+      child->slots.back().leaf = std::move(s.leaf);
+      s.leaf.reset();
+      s.child = std::move(child);
+    }
+  }
+
+  T &operator[](const Key &key)
+  {
+    return insert(value_type(key, T())).first->second;
+  }
+
+  size_t erase(const Key &key)
+  {
+    const_iterator it;
+    if(!lookup(key, false, it))
+      return 0;
+
+    erase_rec(root, Hash()(key), 0, key);
+    num_elems--;
+    return 1;
+  }
+
+protected:
+  template <class P>
+  static void unshare(std::shared_ptr<P> &ptr)
+  {
+    if(ptr.use_count() != 1)
+      ptr = std::make_shared<P>(*ptr);
+  }
+
+  static void unshare_all(node_ptrt &node)
+  {
+    unshare(node);
+    for(auto &s : node->slots)
+    {
+      if(s.child)
+        unshare_all(s.child);
+      else
+        unshare(s.leaf);
+    }
+  }
+
+  template <class I>
+  bool lookup(const Key &key, bool for_writing, I &it) const
+  {
+    size_t hash = Hash()(key);
+    node_ptrt *node = const_cast<node_ptrt *>(&root);
+    size_t shift = 0;
+    it.stack.clear();
+
+    for(;;)
+    {
+      if(for_writing)
+        unshare(*node);
+
+      nodet &n = **node;
+      unsigned int bit = (hash >> shift) & slot_mask;
+      if(!(n.bitmap & (1u << bit)))
+        break;
+
+      unsigned int idx = n.index(bit);
+      it.stack.emplace_back(&n, idx);
+
+      slott &s = n.slots[idx];
+      if(s.child)
+      {
+        node = &s.child;
+        shift += bits;
+        continue;
+      }
+
+      if(s.leaf->hash != hash)
+        break;
+
+      if(for_writing)
+        unshare(s.leaf);
+
+      const std::vector<value_type> &entries = s.leaf->entries;
+      for(unsigned int i = 0; i < entries.size(); i++)
+      {
+        if(KeyEqual()(entries[i].first, key))
+        {
+          it.entry = i;
+          return true;
+        }
+      }
+      break;
+    }
+
+    it.stack.clear();
+    it.entry = 0;
+    return false;
+  }
+
+  // Removes a key known to be present; returns true if node became empty
+  static bool
+  erase_rec(node_ptrt &node, size_t hash, size_t shift, const Key &key)
+  {
+    unshare(node);
+    nodet &n = *node;
+    unsigned int bit = (hash >> shift) & slot_mask;
+    assert(n.bitmap & (1u << bit));
+    unsigned int idx = n.index(bit);
+    slott &s = n.slots[idx];
+
+    bool remove_slot;
+    if(s.child)
+    {
+      remove_slot = erase_rec(s.child, hash, shift + bits, key);
+    }
+    else
+    {
+      unshare(s.leaf);
+      std::vector<value_type> &entries = s.leaf->entries;
+      for(auto it = entries.begin(); it != entries.end(); it++)
+      {
+        if(KeyEqual()(it->first, key))
+        {
+          entries.erase(it);
+          break;
+        }
+      }
+      remove_slot = entries.empty();
+    }
+
+    if(remove_slot)
+    {
+      n.slots.erase(n.slots.begin() + idx);
+      n.bitmap &= ~(1u << bit);
+    }
+
+    return n.slots.empty();
+  }
+
+  node_ptrt root;
+  size_t num_elems;
+};
+
+#endif /* UTIL_PERSISTENT_MAP_H_ */
@@ -13,23 +13,23 @@ expr2tc expr2t::do_simplify() const
   return expr2tc();
 }
 
-expr2tc expr2t::simplify() const
+static expr2tc simplify_uncached(const expr2t &self)
 {
   try
   {
     // Corner case! Don't even try to simplify address of's operands, might end up
     // taking the address of some /completely/ arbitary pice of data, by
     // simplifiying an index to its data, discarding the symbol.
-    if(expr_id == address_of_id) // unlikely
+    if(self.expr_id == expr2t::address_of_id) // unlikely
       return expr2tc();
 
     // And overflows too. We don't wish an add to distribute itself, for example,
     // when we're trying to work out whether or not it's going to overflow.
-    if(expr_id == overflow_id)
+    if(self.expr_id == expr2t::overflow_id)
       return expr2tc();
 
     // Try initial simplification
-    expr2tc res = do_simplify();
+    expr2tc res = self.do_simplify();
     if(!is_nil_expr(res))
     {
       // Woot, we simplified some of this. It may have _additional_ fields that
@@ -48,9 +48,9 @@ expr2tc expr2t::simplify() const
     bool changed = false;
     std::list<expr2tc> newoperands;
 
-    for(unsigned int idx = 0; idx < get_num_sub_exprs(); idx++)
+    for(unsigned int idx = 0; idx < self.get_num_sub_exprs(); idx++)
     {
-      const expr2tc *e = get_sub_expr(idx);
+      const expr2tc *e = self.get_sub_expr(idx);
       expr2tc tmp;
 
       if(!is_nil_expr(*e))
@@ -68,10 +68,10 @@ expr2tc expr2t::simplify() const
       // holding something back until it's certain all its operands are
       // simplified. It's responsible for simplifying further if it's made that
       // call though.
-      return do_simplify();
+      return self.do_simplify();
 
     // An operand has been changed; clone ourselves and update.
-    expr2tc new_us = clone();
+    expr2tc new_us = self.clone();
     std::list<expr2tc>::iterator it2 = newoperands.begin();
     new_us->Foreach_operand([&it2](expr2tc &e) {
       if((*it2) == nullptr)
@@ -98,6 +98,58 @@ expr2tc expr2t::simplify() const
   }
 }
 
+expr2tc expr2t::simplify() const
+{
+  if(simplify_cache.capacity == 0)
+    return simplify_uncached(*this);
+
+  // Simplified exprs always live in a container, so this can be used as key
+  expr2tc key(std::const_pointer_cast<expr2t>(shared_from_this()));
+
+  expr2tc res;
+  if(simplify_cache.lookup(key, res))
+    return res;
+
+  res = simplify_uncached(*this);
+  simplify_cache.insert(key, res);
+  return res;
+}
+
+simplify_cachet::simplify_cachet() : capacity(1 << 16), hits(0), misses(0)
+{
+}
+
+bool simplify_cachet::lookup(const expr2tc &expr, expr2tc &res)
+{
+  auto it = cache.find(expr);
+  if(it == cache.end())
+  {
+    misses++;
+    return false;
+  }
+
+  hits++;
+  res = it->second;
+  return true;
+}
+
+void simplify_cachet::insert(const expr2tc &expr, const expr2tc &res)
+{
+  // Simple bound: start over once full, the hot terms come back quickly
+  if(cache.size() >= capacity)
+    cache.clear();
+
+  cache.emplace(expr, res);
+}
+
+void simplify_cachet::set_capacity(size_t size)
+{
+  capacity = size;
+  cache.clear();
+}
+
+simplify_cachet simplify_cache;
+
 static expr2tc try_simplification(const expr2tc &expr)
 {
   expr2tc to_simplify = expr->do_simplify();
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <util/state_hash.h>
+
+static const uint64_t c1 = 0x87c37b91114253d5ULL;
+static const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+static inline uint64_t rotl64(uint64_t x, int r)
+{
+  return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t fmix64(uint64_t k)
+{
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+std::string state_hasht::to_string() const
+{
+  std::ostringstream buf;
+  buf << std::hex << std::setfill('0') << std::setw(16) << h1 << std::setw(16)
+      << h2;
+  return buf.str();
+}
+
+state_hashert::state_hashert() : h1(0), h2(0), tail_len(0), total_len(0)
+{
+}
+
+void state_hashert::mix_block(uint64_t k1, uint64_t k2)
+{
+  k1 *= c1;
+  k1 = rotl64(k1, 31);
+  k1 *= c2;
+  h1 ^= k1;
+
+  h1 = rotl64(h1, 27);
+  h1 += h2;
+  h1 = h1 * 5 + 0x52dce729;
+
+  k2 *= c2;
+  k2 = rotl64(k2, 33);
+  k2 *= c1;
+  h2 ^= k2;
+
+  h2 = rotl64(h2, 31);
+  h2 += h1;
+  h2 = h2 * 5 + 0x38495ab5;
+}
+
+void state_hashert::ingest(void const *data, unsigned int size)
+{
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  total_len += size;
+
+  while(size > 0)
+  {
+    unsigned int n = std::min(size, 16 - tail_len);
+    memcpy(&tail[tail_len], bytes, n);
+    tail_len += n;
+    bytes += n;
+    size -= n;
+
+    if(tail_len == 16)
+    {
+      uint64_t k1, k2;
+      memcpy(&k1, &tail[0], 8);
+      memcpy(&k2, &tail[8], 8);
+      mix_block(k1, k2);
+      tail_len = 0;
+    }
+  }
+}
+
+state_hasht state_hashert::fin()
+{
+  if(tail_len != 0)
+  {
+    uint64_t k1 = 0, k2 = 0;
+    memset(&tail[tail_len], 0, 16 - tail_len);
+    memcpy(&k1, &tail[0], 8);
+    memcpy(&k2, &tail[8], 8);
+
+    k2 *= c2;
+    k2 = rotl64(k2, 33);
+    k2 *= c1;
+    h2 ^= k2;
+
+    k1 *= c1;
+    k1 = rotl64(k1, 31);
+    k1 *= c2;
+    h1 ^= k1;
+  }
+
+  h1 ^= total_len;
+  h2 ^= total_len;
+  h1 += h2;
+  h2 += h1;
+  h1 = fmix64(h1);
+  h2 = fmix64(h2);
+  h1 += h2;
+  h2 += h1;
+
+  state_hasht res;
+  res.h1 = h1;
+  res.h2 = h2;
+
+  // Zero is reserved for empty slots in state_hash_sett
+  if(res.is_zero())
+    res.h1 = 1;
+
+  return res;
+}
+
+state_hash_sett::state_hash_sett() : slots(1024), num_elems(0)
+{
+}
+
+size_t state_hash_sett::find_slot(const state_hasht &hash) const
+{
+  // The table size is a power of two and the hash is already well mixed
+  size_t mask = slots.size() - 1;
+  size_t idx = hash.h1 & mask;
+  while(!slots[idx].is_zero() && slots[idx] != hash)
+    idx = (idx + 1) & mask;
+
+  return idx;
+}
+
+bool state_hash_sett::insert(const state_hasht &hash)
+{
+  size_t idx = find_slot(hash);
+  if(!slots[idx].is_zero())
+    return false;
+
+  slots[idx] = hash;
+  num_elems++;
+
+  // Keep the load factor under one half, probe sequences stay short
+  if(num_elems * 2 > slots.size())
+    grow();
+
+  return true;
+}
+
+bool state_hash_sett::contains(const state_hasht &hash) const
+{
+  return !slots[find_slot(hash)].is_zero();
+}
+
+void state_hash_sett::grow()
+{
+  std::vector<state_hasht> old;
+  old.swap(slots);
+  slots.resize(old.size() * 2);
+
+  for(const auto &hash : old)
+    if(!hash.is_zero())
+      slots[find_slot(hash)] = hash;
+}
@@ -0,0 +1,99 @@
+#ifndef UTIL_STATE_HASH_H_
+#define UTIL_STATE_HASH_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/** 128 bit hash of (part of) a symex state.
+ *  This isn't a cryptographic hash; it only has to tell explored states apart.
+ *  Hashes of independent parts of the state can be combined with ^=, which is
+ *  what lets the state hash be updated in O(1) on each assignment, see
+ *  execution_statet::state_hashing_level2t. */
+class state_hasht
+{
+public:
+  state_hasht() : h1(0), h2(0)
+  {
+  }
+
+  bool operator==(const state_hasht &ref) const
+  {
+    return h1 == ref.h1 && h2 == ref.h2;
+  }
+
+  bool operator!=(const state_hasht &ref) const
+  {
+    return !(*this == ref);
+  }
+
+  bool operator<(const state_hasht &ref) const
+  {
+    return h1 < ref.h1 || (h1 == ref.h1 && h2 < ref.h2);
+  }
+
+  state_hasht &operator^=(const state_hasht &ref)
+  {
+    h1 ^= ref.h1;
+    h2 ^= ref.h2;
+    return *this;
+  }
+
+  bool is_zero() const
+  {
+    return h1 == 0 && h2 == 0;
+  }
+
+  std::string to_string() const;
+
+  uint64_t h1;
+  uint64_t h2;
+};
+
+/** Streaming hasher producing a state_hasht.
+ *  Uses the MurmurHash3 x64 128 bit block and finalisation functions; input
+ *  is buffered a block at a time, so ingesting never allocates. */
+class state_hashert
+{
+public:
+  state_hashert();
+
+  void ingest(void const *data, unsigned int size);
+  state_hasht fin();
+
+protected:
+  void mix_block(uint64_t k1, uint64_t k2);
+
+  uint64_t h1;
+  uint64_t h2;
+  uint8_t tail[16];
+  unsigned int tail_len;
+  uint64_t total_len;
+};
+
+/** Set of state hashes, stored in a flat open-addressing table with linear
+ *  probing. The all-zero hash marks free slots; state_hashert::fin never
+ *  produces it. */
+class state_hash_sett
+{
+public:
+  state_hash_sett();
+
+  /** @return True if the hash was not already in the set */
+  bool insert(const state_hasht &hash);
+  bool contains(const state_hasht &hash) const;
+
+  size_t size() const
+  {
+    return num_elems;
+  }
+
+protected:
+  size_t find_slot(const state_hasht &hash) const;
+  void grow();
+
+  std::vector<state_hasht> slots;
+  size_t num_elems;
+};
+
+#endif /* UTIL_STATE_HASH_H_ */
@@ -0,0 +1,115 @@
+/*******************************************************************
+ Module: Value set unit test
+
+ Test Plan:
+   - Merging value sets that share entries
+   - Merges that change nothing keep everything shared
+ \*******************************************************************/
+
+#define BOOST_TEST_MODULE "Value Set"
+
+#include <langapi/mode.h>
+#include <pointer-analysis/value_set.h>
+#include <util/context.h>
+#include <util/irep2_utils.h>
+#include <util/namespace.h>
+#include <boost/test/included/unit_test.hpp>
+namespace utf = boost::unit_test;
+
+// No language frontends, printing expressions falls back to the default
+const mode_table_et mode_table[] = {LANGAPI_HAVE_MODE_END};
+
+namespace
+{
+const unsigned int num_ptrs = 64;
+
+std::string ptr_name(unsigned int i)
+{
+  return "ptr" + std::to_string(i);
+}
+
+// Make pointer i of vs point at the object called obj
+void point_at(value_sett &vs, unsigned int i, const std::string &obj)
+{
+  value_sett::entryt e(ptr_name(i), "");
+  auto it = vs.values.find(ptr_name(i));
+  if(it != vs.values.end())
+    e = it->second;
+
+  vs.insert(e.object_map, symbol2tc(signedbv_type2tc(32), obj), BigInt(0));
+  vs.values.erase(ptr_name(i));
+  vs.values.insert(std::make_pair(irep_idt(ptr_name(i)), e));
+}
+
+// Do vs1 and vs2 share the record of pointer i?
+bool shared(const value_sett &vs1, const value_sett &vs2, unsigned int i)
+{
+  return &vs1.values.find(ptr_name(i))->second ==
+         &vs2.values.find(ptr_name(i))->second;
+}
+} // namespace
+
+// ******************** TESTS ********************
+
+BOOST_AUTO_TEST_SUITE(make_union)
+
+BOOST_AUTO_TEST_CASE(merge_copy)
+{
+  contextt ctx;
+  namespacet ns(ctx);
+  value_sett vs(ns);
+  for(unsigned int i = 0; i < num_ptrs; i++)
+    point_at(vs, i, "obj" + std::to_string(i));
+
+  value_sett other(vs);
+  BOOST_TEST(!vs.make_union(other, true));
+  BOOST_TEST(vs.values.shares_root(other.values));
+}
+
+BOOST_AUTO_TEST_CASE(merge_changing_nothing)
+{
+  contextt ctx;
+  namespacet ns(ctx);
+  value_sett vs(ns);
+  for(unsigned int i = 0; i < num_ptrs; i++)
+    point_at(vs, i, "obj" + std::to_string(i));
+
+  // The other side of the merge has an entry of its own, with objects this
+  // one already points at, and a new pointer that isn't kept
+  value_sett other(vs);
+  point_at(other, 0, "obj0");
+  point_at(other, num_ptrs, "obj0");
+  BOOST_TEST(!shared(vs, other, 0));
+
+  value_sett snapshot(vs);
+  BOOST_TEST(!vs.make_union(other, false));
+  BOOST_TEST(vs.values.shares_root(snapshot.values));
+  for(unsigned int i = 1; i < num_ptrs; i++)
+    BOOST_TEST(shared(vs, other, i));
+}
+
+BOOST_AUTO_TEST_CASE(merge_adding_objects)
+{
+  contextt ctx;
+  namespacet ns(ctx);
+  value_sett vs(ns);
+  for(unsigned int i = 0; i < num_ptrs; i++)
+    point_at(vs, i, "obj" + std::to_string(i));
+
+  value_sett other(vs);
+  point_at(other, 0, "extra");
+
+  value_sett snapshot(vs);
+  BOOST_TEST(vs.make_union(other, false));
+  BOOST_TEST(vs.values.find(ptr_name(0))->second.object_map.size() == 2);
+  BOOST_TEST(snapshot.values.find(ptr_name(0))->second.object_map.size() == 1);
+
+  // Only the merged entry got unshared
+  for(unsigned int i = 1; i < num_ptrs; i++)
+  {
+    BOOST_TEST(shared(vs, snapshot, i));
+    BOOST_TEST(shared(vs, other, i));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
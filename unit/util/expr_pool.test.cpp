@@ -0,0 +1,69 @@
+/*******************************************************************
+ Module: Expression pool unit test
+
+ Test Plan:
+   - Duplicates are replaced by the pooled expression
+   - Deep expressions with a duplicated leaf are interned in one pass
+ \*******************************************************************/
+
+#define BOOST_TEST_MODULE "Expression Pool"
+
+#include <util/irep2_expr.h>
+#include <util/irep2_utils.h>
+#include <boost/test/included/unit_test.hpp>
+namespace utf = boost::unit_test;
+
+namespace
+{
+// Non-const get() detaches shared expressions, so compare through this
+const expr2t *ptr(const expr2tc &e)
+{
+  return e.get();
+}
+} // namespace
+
+// ******************** TESTS ********************
+
+BOOST_AUTO_TEST_SUITE(intern)
+
+BOOST_AUTO_TEST_CASE(duplicate_is_replaced)
+{
+  expr2tc a = symbol2tc(get_bool_type(), "pool_dup_a");
+  expr_pool.intern(a);
+
+  expr2tc b = symbol2tc(get_bool_type(), "pool_dup_a");
+  BOOST_TEST(ptr(a) != ptr(b));
+  expr_pool.intern(b);
+  BOOST_TEST(ptr(a) == ptr(b));
+
+  // Interning the pooled expression again is a no-op
+  expr_pool.intern(b);
+  BOOST_TEST(ptr(a) == ptr(b));
+}
+
+BOOST_AUTO_TEST_CASE(deep_chain_with_duplicate_leaf)
+{
+  expr2tc leaf = symbol2tc(get_bool_type(), "pool_chain_leaf");
+  expr_pool.intern(leaf);
+
+  // A fresh chain whose innermost operand duplicates the pooled leaf:
+  // everything above it has to be rebuilt, which must happen once per node.
+  const unsigned int depth = 64;
+  expr2tc chain = symbol2tc(get_bool_type(), "pool_chain_leaf");
+  for(unsigned int i = 0; i < depth; i++)
+    chain = and2tc(
+      chain, symbol2tc(get_bool_type(), "pool_chain_" + std::to_string(i)));
+
+  unsigned long hits = expr_pool.hits, misses = expr_pool.misses;
+  expr_pool.intern(chain);
+
+  BOOST_TEST(expr_pool.hits - hits == 1);
+  BOOST_TEST(expr_pool.misses - misses == 2 * depth);
+
+  const expr2t *e = ptr(chain);
+  for(unsigned int i = 0; i < depth; i++)
+    e = ptr(static_cast<const and2t *>(e)->side_1);
+  BOOST_TEST(e == ptr(leaf));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,223 @@
+/*******************************************************************
+ Module: Guard unit test
+
+ Test Plan:
+   - Disjunction keeps the common prefix and ors the suffixes
+   - Subtraction strips the shared prefix
+   - True and false guards
+   - Equal guards built along different paths are the same node
+ \*******************************************************************/
+
+#define BOOST_TEST_MODULE "Guard"
+
+#include <util/guard.h>
+#include <util/irep2_utils.h>
+#include <boost/test/included/unit_test.hpp>
+namespace utf = boost::unit_test;
+
+namespace
+{
+// Set up the type pool, as esbmc's main does
+struct type_pool_fixturet
+{
+  type_pool_fixturet()
+  {
+    type_poolt pool(true);
+    type_pool = pool;
+  }
+};
+
+expr2tc sym(const std::string &name)
+{
+  return symbol2tc(get_bool_type(), name);
+}
+
+guardt make_guard(const std::vector<expr2tc> &literals)
+{
+  guardt g;
+  for(auto const &it : literals)
+    g.add(it);
+  return g;
+}
+
+std::vector<expr2tc> chain(const std::string &prefix, unsigned int length)
+{
+  std::vector<expr2tc> res;
+  for(unsigned int i = 0; i < length; i++)
+    res.push_back(sym(prefix + std::to_string(i)));
+  return res;
+}
+
+std::vector<expr2tc>
+slice(const std::vector<expr2tc> &v, unsigned int from, unsigned int to)
+{
+  return std::vector<expr2tc>(v.begin() + from, v.begin() + to);
+}
+
+std::vector<expr2tc>
+concat(std::vector<expr2tc> a, const std::vector<expr2tc> &b)
+{
+  a.insert(a.end(), b.begin(), b.end());
+  return a;
+}
+} // namespace
+
+BOOST_GLOBAL_FIXTURE(type_pool_fixturet);
+
+// ******************** TESTS ********************
+
+BOOST_AUTO_TEST_SUITE(disjunction)
+
+BOOST_AUTO_TEST_CASE(common_prefix)
+{
+  expr2tc a = sym("a"), b = sym("b"), c = sym("c"), d = sym("d");
+  guardt g1 = make_guard({a, b, c});
+  guardt g2 = make_guard({a, b, d});
+
+  g1 |= g2;
+  guardt expected = make_guard({a, b, or2tc(c, d)});
+  BOOST_TEST((g1 == expected));
+  BOOST_TEST((g1.as_expr() == and2tc(and2tc(a, b), or2tc(c, d))));
+}
+
+BOOST_AUTO_TEST_CASE(common_prefix_deep)
+{
+  // Prefixes and suffixes of many lengths, to get through the jump pointers
+  for(unsigned int p = 0; p < 40; p += 3)
+  {
+    for(unsigned int s1 = 1; s1 < 12; s1 += 2)
+    {
+      std::vector<expr2tc> prefix = chain("p", p);
+      std::vector<expr2tc> suffix1 = chain("x", s1);
+      std::vector<expr2tc> suffix2 = chain("y", 1);
+
+      guardt g1 = make_guard(concat(prefix, suffix1));
+      guardt g2 = make_guard(concat(prefix, suffix2));
+      g1 |= g2;
+
+      guardt expected = make_guard(prefix);
+      expected.add(
+        or2tc(make_guard(suffix1).as_expr(), make_guard(suffix2).as_expr()));
+      BOOST_TEST((g1 == expected));
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(prefix_of_other)
+{
+  expr2tc a = sym("a"), b = sym("b"), c = sym("c");
+  guardt shorter = make_guard({a, b});
+  guardt longer = make_guard({a, b, c});
+
+  guardt g = shorter;
+  g |= longer;
+  BOOST_TEST((g == shorter));
+
+  g = longer;
+  g |= shorter;
+  BOOST_TEST((g == shorter));
+}
+
+BOOST_AUTO_TEST_CASE(opposite_symbols)
+{
+  expr2tc a = sym("a");
+  guardt g1 = make_guard({a});
+  guardt g2 = make_guard({not2tc(a)});
+
+  g1 |= g2;
+  BOOST_TEST(g1.is_true());
+}
+
+BOOST_AUTO_TEST_CASE(true_and_false)
+{
+  guardt t, f, g = make_guard({sym("a"), sym("b")});
+  f.make_false();
+  BOOST_TEST(t.is_true());
+  BOOST_TEST(f.is_false());
+
+  guardt res = g;
+  res |= f;
+  BOOST_TEST((res == g));
+
+  res = f;
+  res |= g;
+  BOOST_TEST((res == g));
+
+  res = g;
+  res |= t;
+  BOOST_TEST(res.is_true());
+
+  res = t;
+  res |= g;
+  BOOST_TEST(res.is_true());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(subtraction)
+
+BOOST_AUTO_TEST_CASE(shared_prefix)
+{
+  expr2tc a = sym("a"), b = sym("b"), c = sym("c"), d = sym("d");
+  guardt g1 = make_guard({a, b, c});
+  g1 -= make_guard({a, b});
+  BOOST_TEST((g1 == make_guard({c})));
+
+  // Literals of g2 past the common prefix go too
+  g1 = make_guard({a, b, c});
+  g1 -= make_guard({a, d, c});
+  BOOST_TEST((g1 == make_guard({b})));
+
+  // Subtracting a guard from itself leaves true
+  g1 = make_guard({a, b, c});
+  g1 -= make_guard({a, b, c});
+  BOOST_TEST(g1.is_true());
+}
+
+BOOST_AUTO_TEST_CASE(true_guard)
+{
+  guardt t, g = make_guard({sym("a"), sym("b")});
+
+  guardt res = g;
+  res -= t;
+  BOOST_TEST((res == g));
+
+  res = t;
+  res -= g;
+  BOOST_TEST(res.is_true());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(hash_consing)
+
+BOOST_AUTO_TEST_CASE(different_paths)
+{
+  std::vector<expr2tc> literals = chain("l", 50);
+
+  guardt g1 = make_guard(literals);
+
+  // Built in pieces, from copies, and with a conjunction
+  guardt g2 = make_guard(slice(literals, 0, 20));
+  guardt copy = g2;
+  for(unsigned int i = 20; i < 48; i++)
+    copy.add(literals[i]);
+  copy.add(and2tc(literals[48], literals[49]));
+
+  BOOST_TEST((g1 == copy));
+  // Even the conjunctions are shared (non-const get() would detach them)
+  const expr2tc &e1 = g1.as_expr(), &e2 = copy.as_expr();
+  BOOST_TEST((e1.get() == e2.get()));
+
+  // Appending a guard is adding its literals
+  guardt g3 = make_guard(slice(literals, 0, 10));
+  g3.append(make_guard(slice(literals, 10, 50)));
+  BOOST_TEST((g1 == g3));
+
+  // The common prefix is shared, the rest isn't
+  guardt other = g2;
+  other.add(sym("other"));
+  BOOST_TEST(!(other == g1));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
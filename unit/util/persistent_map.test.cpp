@@ -0,0 +1,162 @@
+/*******************************************************************
+ Module: Persistent map unit test
+
+ Test Plan:
+   - Insertion, lookup and erasure
+   - Hash collisions
+   - Sharing between copies
+   - Mutable iteration
+ \*******************************************************************/
+
+#define BOOST_TEST_MODULE "Persistent Map"
+
+#include <map>
+#include <util/persistent_map.h>
+#include <boost/test/included/unit_test.hpp>
+namespace utf = boost::unit_test;
+
+namespace
+{
+// Sends every multiple of 8 to the same hash, to exercise collision leaves
+struct collide_hash
+{
+  size_t operator()(int x) const
+  {
+    return x % 8 == 0 ? 42 : (size_t)x * 0x9e3779b97f4a7c15ULL;
+  }
+};
+
+typedef persistent_mapt<int, int, collide_hash> mapt;
+
+std::map<int, int> contents(const mapt &m)
+{
+  std::map<int, int> res;
+  for(const auto &e : m)
+    res[e.first] = e.second;
+  return res;
+}
+} // namespace
+
+// ******************** TESTS ********************
+
+BOOST_AUTO_TEST_SUITE(Basic)
+BOOST_AUTO_TEST_CASE(insert_find_erase)
+{
+  mapt m;
+  BOOST_TEST(m.empty());
+
+  for(int i = 0; i < 1000; i++)
+    m[i] = i * 2;
+
+  BOOST_TEST(m.size() == 1000);
+  for(int i = 0; i < 1000; i++)
+  {
+    mapt::const_iterator it = m.find(i);
+    BOOST_TEST((it != m.end()));
+    BOOST_TEST(it->second == i * 2);
+  }
+  BOOST_TEST((m.find(1000) == m.end()));
+
+  for(int i = 0; i < 1000; i += 2)
+    BOOST_TEST(m.erase(i) == 1);
+  BOOST_TEST(m.erase(0) == 0);
+
+  BOOST_TEST(m.size() == 500);
+  for(int i = 0; i < 1000; i++)
+    BOOST_TEST(m.count(i) == (size_t)(i % 2));
+}
+
+BOOST_AUTO_TEST_CASE(insert_existing)
+{
+  mapt m;
+  BOOST_TEST(m.insert(std::make_pair(16, 1)).second);
+  BOOST_TEST(m.insert(std::make_pair(24, 2)).second);
+
+  auto r = m.insert(std::make_pair(16, 3));
+  BOOST_TEST(!r.second);
+  BOOST_TEST(r.first->second == 1);
+  BOOST_TEST(m.size() == 2);
+}
+
+BOOST_AUTO_TEST_CASE(iteration)
+{
+  mapt m;
+  std::map<int, int> expected;
+  for(int i = 0; i < 300; i++)
+  {
+    m[i * 3] = i;
+    expected[i * 3] = i;
+  }
+
+  BOOST_TEST((contents(m) == expected));
+}
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(Sharing)
+BOOST_AUTO_TEST_CASE(copies_are_independent)
+{
+  mapt m;
+  for(int i = 0; i < 500; i++)
+    m[i] = i;
+
+  mapt snapshot = m;
+  std::map<int, int> expected = contents(m);
+
+  m[3] = 100;
+  m.erase(8);
+  m[1000] = 1;
+  m.find_mutable(40)->second = -40;
+
+  BOOST_TEST((contents(snapshot) == expected));
+  BOOST_TEST(snapshot.size() == 500);
+  BOOST_TEST(m.size() == 500);
+  BOOST_TEST(m.find(3)->second == 100);
+  BOOST_TEST(m.find(40)->second == -40);
+  BOOST_TEST(snapshot.find(40)->second == 40);
+}
+
+BOOST_AUTO_TEST_CASE(mutable_iteration)
+{
+  mapt m;
+  for(int i = 0; i < 100; i++)
+    m[i] = i;
+
+  mapt snapshot = m;
+  for(auto it = m.begin_mutable(); it != m.end_mutable(); ++it)
+    it->second++;
+
+  for(int i = 0; i < 100; i++)
+  {
+    BOOST_TEST(m.find(i)->second == i + 1);
+    BOOST_TEST(snapshot.find(i)->second == i);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(find_mutable_missing)
+{
+  mapt m;
+  m[1] = 1;
+  BOOST_TEST((m.find_mutable(2) == m.end_mutable()));
+}
+
+BOOST_AUTO_TEST_CASE(shared_root)
+{
+  mapt m;
+  for(int i = 0; i < 100; i++)
+    m[i] = i;
+
+  mapt snapshot = m;
+  BOOST_TEST(m.shares_root(snapshot));
+
+  // Reading leaves everything shared
+  BOOST_TEST(m.find(40)->second == 40);
+  BOOST_TEST(&m.find(40)->second == &snapshot.find(40)->second);
+  BOOST_TEST(m.shares_root(snapshot));
+
+  // Writing unshares the path to the entry, but not the other entries
+  m.find_mutable(40)->second = -40;
+  BOOST_TEST(!m.shares_root(snapshot));
+  BOOST_TEST(&m.find(40)->second != &snapshot.find(40)->second);
+  BOOST_TEST(&m.find(41)->second == &snapshot.find(41)->second);
+}
+BOOST_AUTO_TEST_SUITE_END()